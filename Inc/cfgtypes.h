@@ -14,8 +14,9 @@
  * CFG_CELSIUS		- The temperature units: Celsius (1) or Fahrenheit (0)
  * CFG_BUZZER		- Is the Buzzer Enabled (1)
  * CFG_KEEP_IRON	- Is keep the iron working while in Hot Air Gun mode
+ * CFG_ADAPT		- Retune the PID by the IRON model identified online (1), see MWORK_IRON::trackModel()
  */
-typedef enum { CFG_CELSIUS = 1, CFG_BUZZER = 2, CFG_SWITCH = 4 } CFG_BIT_MASK;
+typedef enum { CFG_CELSIUS = 1, CFG_BUZZER = 2, CFG_SWITCH = 4, CFG_ADAPT = 8 } CFG_BIT_MASK;
 
 /* Configuration record in the EEPROM (after the tip table) has the following format:
  * Records are aligned by 2**n bytes (in this case, 32 bytes)
@@ -28,6 +29,12 @@ typedef enum { CFG_CELSIUS = 1, CFG_BUZZER = 2, CFG_SWITCH = 4 } CFG_BIT_MASK;
  * 0000 -  5 seconds
  * 0001 - 10 seconds
  * 1111 - 80 seconds
+ *
+ * PID weight is two 4-bits setpoint weights of the PID in tenths plus one (see PIDparam). The upper 4 bits are the proportional term weight b,
+ * the lower 4 bits are the derivative term weight c. The zero field is not set, the default weight is used (b = 1.0, c = 0.0), i.e.
+ * 0xB1 - b = 1.0, c = 0.0
+ * 0x11 - b = 0.0, c = 0.0
+ * 0x00 - b = 1.0, c = 0.0 (the records saved before the weights were introduced)
  */
 typedef struct s_config RECORD;
 struct s_config {
@@ -42,22 +49,52 @@ struct s_config {
 	uint8_t		bit_mask;							// See CFG_BIT_MASK enum
 	uint8_t		boost;								// Two 4-bits parameters: The boost increment temperature and boost time. See description above
 	uint8_t		scr_save_timeout;					// The screen saver timeout (in minutes) [0-60]. Zero if disabled
+	uint8_t		settle;								// The amplifier settle time after the IRON power off (TIM2 ticks). Zero if not measured
+	uint8_t		pid_weight;							// Two 4-bits PID setpoint weights: b and c. See description above
+};
+
+/*
+ * The PID gain schedule is saved in the last chunk of the configuration area.
+ * Every band is tuned at its reference temperature by the relay method (see MAUTOPID), the band temperatures increase.
+ * The PID coefficients between the reference temperatures are interpolated, see IRON::setTemp()
+ */
+#define PID_BANDS		(3)
+typedef struct s_pid_schedule PID_SCHEDULE;
+struct s_pid_schedule {
+	uint16_t	temp[PID_BANDS];					// The band reference temperature (internal units), 0 if the band is not tuned
+	uint16_t	Kp[PID_BANDS];						// The PID coefficients of the band
+	uint16_t	Ki[PID_BANDS];
+	uint16_t	Kd[PID_BANDS];
+	uint16_t	crc;								// The checksum
 };
 
 /* Configuration data of each initialized tip are saved in the upper area of the EEPROM.
- * Two tip record per one EEPROM chunk, as soon each tip recored requires 16 bytes only.
+ * One tip record per one EEPROM chunk.
  * The tip configuration record has the following format:
  * 4 reference temperature points
  * tip status bitmap
  * tip suffix name
+ * the holding power model
+ * the PID parameters of the tip (if TIP_PID bit of the mask is set) and the IRON model (the Smith predictor is used if TIP_SMITH bit is set).
+ * The model is also updated by the online identification, see MWORK_IRON::trackModel()
+ * the thermal lag of the heat-up (see IRON::heatUp()) in 20 ms units, zero if not measured yet
+ * The record of the first version had 16 bytes (two records per chunk, the holding power model in the upper bits of the mask),
+ * the tip area is upgraded when the controller starts, see EEPROM::upgradeTipArea()
  */
+#define TIP_VERSION		(2)
 
 typedef struct s_tip TIP;
 struct s_tip {
 	uint16_t	t200, t260, t330, t400;				// The internal temperature in reference points
-	uint8_t		mask;								// The bit mask: TIP_ACTIVE + TIP_CALIBRATED
+	uint8_t		mask;								// The bit mask: TIP_ACTIVE + TIP_CALIBRATED + TIP_PID
 	char		name[tip_name_sz];					// T12 tip name suffix, JL02 for T12-JL02
 	int8_t		ambient;							// The ambient temperature when the tip being calibrated (Celsius)
+	uint8_t		version;							// The record version, TIP_VERSION
+	uint8_t		hold;								// The holding power model, see TIP_HOLD_MAX
+	uint8_t		pid_weight;							// The PID parameters of the tip: setpoint weights (see RECORD) and coefficients
+	uint16_t	pid_Kp, pid_Ki, pid_Kd;
+	uint16_t	model_gain, model_tau, model_dead;	// The IRON model identified with the tip PID parameters, see PIDmodel
+	int8_t		lag;								// The thermal lag of the heat-up, 20 ms units
 	uint8_t		crc;								// CRC checksum
 };
 
@@ -81,6 +118,16 @@ struct s_tip_table {
 	uint8_t		tip_mask;							// The bit mask: 0 - active, 1 - calibrated
 };
 
-typedef enum tip_status { TIP_ACTIVE = 1, TIP_CALIBRATED = 2 } TIP_STATUS;
+typedef enum tip_status { TIP_ACTIVE = 1, TIP_CALIBRATED = 2, TIP_PID = 4, TIP_SMITH = 8 } TIP_STATUS;
+
+/*
+ * The holding power model of the tip:
+ * the power (see IRON::max_power) required to keep the tip 1 Celsius above ambient, in 1/16 units, i.e.
+ * 0  - not learned yet
+ * 17 - 17/16, about 290 to keep 300 Celsius at 25 Celsius ambient
+ * The tip calibration clears the model, so the model is learned again in the new temperature scale. See TIP_CFG::holdPower()
+ * The maximum value is the limit of the first version record that kept the model in the upper 6 bits of the tip mask
+ */
+#define TIP_HOLD_MAX	(63)
 
 #endif
@@ -28,17 +28,20 @@ class CFG_CORE: public TIPS {
 		bool		isCelsius(void) 					{ return a_cfg.bit_mask & CFG_CELSIUS;	}
 		bool		isBuzzerEnabled(void)				{ return a_cfg.bit_mask & CFG_BUZZER; 	}
 		bool		isReedType(void)					{ return a_cfg.bit_mask & CFG_SWITCH;	}
+		bool		isAdaptPID(void)					{ return a_cfg.bit_mask & CFG_ADAPT;	}
 		uint16_t	tempPresetHuman(void) 				{ return a_cfg.temp;					}
 		uint8_t		getOffTimeout(void) 				{ return a_cfg.off_timeout; 			}
 		uint16_t	getLowTemp(void)					{ return a_cfg.low_temp; 				}
 		uint8_t		getLowTO(void)						{ return a_cfg.low_to; 					}
 		uint8_t		getScrTo(void)						{ return a_cfg.scr_save_timeout;		}
+		uint8_t		settleTicks(void)					{ return a_cfg.settle;					}
 		uint8_t		boostTemp(void);
 		uint8_t		boostDuration(void);
-		void		setup(uint8_t off_timeout, bool buzzer, bool celsius, bool reed, uint16_t low_temp, uint8_t low_to, uint8_t scr_saver);
+		void		setup(uint8_t off_timeout, bool buzzer, bool celsius, bool reed, uint16_t low_temp, uint8_t low_to, uint8_t scr_saver, bool adapt);
 		uint8_t		currentTipIndex(void);
 		void 		savePresetTempHuman(uint16_t temp_set);
 		void		saveBoost(uint8_t temp, uint8_t duration);
+		void		saveSettle(uint8_t ticks)			{ a_cfg.settle = ticks;					}
 		void		restoreConfig(void);
 		PIDparam	pidParams(void);
 		PIDparam 	pidParamsSmooth(void);
@@ -47,6 +50,8 @@ class CFG_CORE: public TIPS {
 		void		correctConfig(RECORD *cfg);
 		void		syncConfig(void);
 		bool		areConfigsIdentical(void);
+		static uint8_t	packWeights(const PIDparam& pp);	// The setpoint weights to the record byte, see RECORD
+		static PIDparam	unpackPID(int32_t Kp, int32_t Ki, int32_t Kd, uint8_t weight);
 		RECORD		a_cfg;								// active configuration
 		bool		gun_mode			= false;
 	private:
@@ -75,14 +80,29 @@ class TIP_CFG {
 		void		getTipCalibtarion(uint16_t temp[4]);
 		void		applyTipCalibtarion(uint16_t temp[4], int8_t ambient);
 		void		resetTipCalibration(void);
+		uint16_t	holdPower(uint16_t temp, int16_t ambient);	// The expected power to keep the temperature (internal units), 0 if not learned
+		uint8_t		holdModel(uint16_t temp, int16_t ambient, uint16_t power);	// The model by the power applied at the temperature
+		uint8_t		tipHold(void)						{ return hold;							}
+		bool		isTipPID(void)						{ return tip_pid;						}	// Whether the active tip has its own PID parameters
+		bool		isTipSmith(void)					{ return tip_pid && smith;				}	// Whether the PID of the active tip uses the Smith predictor
+		PIDmodel	pidModel(void)						{ return tip_pid?model:PIDmodel();		}	// The IRON model of the active tip PID
+		PIDmodel	tipModel(void)						{ return model;							}	// The IRON model of the active tip, invalid if unknown
+		int16_t		tipLag(void)						{ return lag * 20;						}	// The thermal lag of the active tip (ms), 0 if unknown
 	protected:
 		void 		defaultCalibration(void);
 		bool		isValidTipConfig(TIP *tip);
+		uint8_t		hold				= 0;			// The holding power model of the active tip, see TIP_HOLD_MAX
+		bool		tip_pid				= false;		// The active tip has its own PID parameters
+		PIDparam	pid;								// The PID parameters of the active tip
+		PIDmodel	model;								// The IRON model of the active tip
+		bool		smith				= false;		// Use the Smith predictor with the model
+		int8_t		lag					= 0;			// The thermal lag of the active tip, see TIP
 	private:
 		TIP_RECORD	tip;								// Active IRON tip
 		uint16_t	t_minC				= iron_temp_minC;
 		uint16_t	t_maxC				= iron_temp_maxC;
 		const uint16_t	temp_ref_iron[4]	= { 200, 260, 330, 400};
+		const uint16_t	hold_min_over		= 100;		// The minimum temperature over ambient (Celsius) to learn the holding power
 };
 
 class CFG : public EEPROM, public CFG_CORE, public TIP_CFG, public BUZZER {
@@ -100,6 +120,11 @@ class CFG : public EEPROM, public CFG_CORE, public TIP_CFG, public BUZZER {
 		int			tipList(uint8_t second, TIP_ITEM list[], uint8_t list_len, bool active_only);
 		void		saveConfig(void);
 		void		savePID(PIDparam &pp);
+		PIDparam	pidParams(void);					// The PID parameters of the current tip or the common ones
+		bool		saveTipPID(PIDparam &pp, const PIDmodel *m = 0, bool smith = false);	// Save the PID parameters of the current tip only, keep the model if m is null
+		bool		saveTipHold(uint8_t hold);			// Save the holding power model of the current tip
+		bool		saveTipModel(const PIDmodel &m);	// Save the IRON model of the current tip, keep the PID parameters
+		bool		saveTipLag(int16_t lag);			// Save the thermal lag of the current tip (ms)
 		void 		initConfigArea(void);
 		void		clearAllTipsCalibration(void);
 	private:
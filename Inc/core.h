@@ -17,12 +17,66 @@ typedef	uint8_t	bool;
 // Forward function declaration
 bool isACsine(void);
 
+// The statistics of the measured value, CPU cycles (DWT)
+typedef struct s_cycle_stat CYCLE_STAT;
+struct s_cycle_stat {
+	uint32_t	min;
+	uint32_t	avg;										// Exponential average
+	uint32_t	max;
+	uint32_t	count;										// Number of measurements
+};
+
+// The timing of the ADC data processing path, CPU cycles (DWT)
+typedef struct s_adc_timing ADC_TIMING;
+struct s_adc_timing {
+	CYCLE_STAT	isr;										// DMA complete interrupt handler
+	CYCLE_STAT	bh;											// The bottom half (PendSV): filtering, PID and CCR1 update
+	CYCLE_STAT	power;										// IRON::power(): the short average and PID
+	CYCLE_STAT	response;									// From the DMA complete interrupt to the CCR1 update
+	CYCLE_STAT	jitter;										// Deviation of the DMA complete interval from TIM2 period
+	uint32_t	bh_late;									// Number of times the bottom half missed its deadline (the next buffer half)
+};
+
+// The front-end of the IRON temperature samples: the boxcar mean, the median of three or the trimmed mean, see adcTempSum()
+typedef enum { ADC_FILTER_MEAN = 0, ADC_FILTER_MEDIAN, ADC_FILTER_TRIMMED } ADC_FILTER;
+
+// The raw data of one measurement cycle, see adcSample()
+typedef struct s_adc_sample ADC_SAMPLE;
+struct s_adc_sample {
+	uint32_t	stamp;										// DWT cycle counter at the DMA complete interrupt
+	uint16_t	temp;										// The IRON temperature, the oversampled ADC reading with frac extra bits
+	uint16_t	current;									// The last reading of the current through the IRON, the zero offset is not subtracted
+	uint16_t	ambient;									// The last ambient reading
+	uint16_t	power;										// The IRON power for the reference TIM2 period (0-1999)
+	uint16_t	pwm;										// CCR1 value of the period with the measurement window
+	uint8_t		rate;										// ADC_RATE
+	uint8_t		frac;
+};
+
+// The control and measurement rates, see adc_rates in core.cpp
+typedef enum { ADC_RATE_SLOW = 0, ADC_RATE_NORMAL, ADC_RATE_FAST, ADC_RATE_CARRIER, ADC_RATE_AUTO } ADC_RATE;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void setup(void);
 void loop(void);
+const ADC_TIMING* adcTiming(void);
+void		adcTimingReset(void);
+void		adcBlanking(uint8_t ticks);						// TIM2 ticks between IRON power off and the measurement window, 0 - default
+uint16_t	adcMaxPower(void);								// Maximum IRON PWM value with the current blanking window
+bool		adcSettleStart(void);							// Start the amplifier settle time measurement
+void		adcSettleStop(void);
+uint8_t		adcSettleProgress(void);						// Measurement progress in percents
+uint8_t		adcSettleResult(void);							// The minimum blanking window (TIM2 ticks) or 0 if failed
+void		adcRate(ADC_RATE rate);							// Fix the control rate, ADC_RATE_AUTO - selected by the controller
+ADC_RATE	adcActiveRate(void);
+void		adcFilter(ADC_FILTER filter);
+uint32_t	adcRejected(void);								// The number of the IRON temperature samples rejected by the front-end
+bool		adcSample(ADC_SAMPLE* s);						// Get the oldest sample, false if none. Single consumer: the main loop
+uint16_t	adcSamples(void);								// The number of samples queued
+uint32_t	adcSampleOverrun(void);							// The number of samples dropped because nobody read them
 
 #ifdef __cplusplus
 }
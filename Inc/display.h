@@ -11,6 +11,8 @@
 #include "main.h"
 #include "oled.h"
 #include "config.h"
+#include "core.h"
+#include "iron.h"
 
 typedef enum { SCR_MODE_ON = 0, SCR_MODE_OFF, SCR_MODE_STBY } SCR_MODE;
 
@@ -32,6 +34,7 @@ class DSPL : public U8G2 {
 		void 		msgStandby(void);
 		void 		msgBoost(void);
 		void 		timeToOff(uint8_t time);
+		void		readyTime(uint32_t ms);					// The time to reach the preset temperature
 		void 		tip(const char *tip_name);
 		void		fanSpeed(uint8_t pcnt);
 		void 		pidInit(void);
@@ -41,7 +44,7 @@ class DSPL : public U8G2 {
 		void		autoPidCurrentLoop(uint16_t loop, uint32_t period);
 		void		pidPutData(int16_t temp, uint16_t disp);
 		void 		pidShowGraph(uint8_t pwr);
-		void 		pidShowMenu(uint16_t pid_k[3], uint8_t index);
+		void 		pidShowMenu(uint16_t pid_k[5], uint8_t index, uint8_t confidence);	// Kp, Ki, Kd, the setpoint weights b, c and the model confidence
 		void		mainShow(uint16_t t_set, uint16_t t_cur, int16_t  t_amb, uint8_t p_applied,
 							bool is_celsius, bool tip_calibrated, bool tilt_iron_used=false);
 		void		scrSave(SCR_MODE mode, uint16_t t_cur);
@@ -55,6 +58,8 @@ class DSPL : public U8G2 {
 		void 		errorShow(void);
 		void		errorMessage(const char *msg);
 		void 		debugShow(uint16_t power, bool iron, bool tilt, uint16_t data[4]);
+		void		debugTiming(const ADC_TIMING* t);		// Average and maximum duration of the ADC data processing, CPU cycles; max jitter and late count
+		void		debugLoad(const IRON_LOAD& e, uint8_t n);	// The latest solder load event and the number of the events logged
 		void		showVersion(void);
 	private:
 		char      	msg_buff[8]	 = {0};                		// the buffer for the message in top right corner
@@ -7,18 +7,19 @@
  * The data in the EEPROM is addressed by chunks.
  * There are 128 chunks of 32 bytes in the EEPROM IC at24c32a.
  * First 64 chunks [0-63] are used to store configuration data.
+ * The chunks [0-62] keep the configuration records, the last chunk (63) keeps the PID gain schedule (see PID_SCHEDULE).
  * One record per chunk as soon the configuration record can fit into one chunk.
  * To save EEPROM rewrite cycles, new record is written to the next free chunk, increasing record ID.
  * When the controller starts, it reads all the chunks in the configuration area and find the last record
  * that has the biggest record ID.
  *
- * Last 64 chunks [64-127] are used to store the tip configuration data.
- * As soon as tip configuration requires only 16 bytes, two records can fit to the chunk.
+ * Last 64 chunks [64-127] are used to store the tip configuration data, one record per chunk.
  * Only active and calibrated tips are stored in this area.
  * When the controller starts, it reads all the chunks in the tip area and builds tip configuration table (tip_table, see config.c).
  * The tip_table tip_chunk_index field is the index of the tip in tip configuration area.
- * index = 0 means the first (of two) record in the first tip configuration chunk (64 chunk of the EEPROM).
- * index = 1 means the second record record in the first tip configuration chunk (64 chunk of the EEPROM).
+ * index = 0 means the first tip configuration chunk (64 chunk of the EEPROM).
+ * The first version tip record required 16 bytes, two records were saved in one chunk.
+ * Such a tip area is upgraded in place when the controller starts, see upgradeTipArea().
  *
  * For chunk manipulations two functions are used: readChunk() and writeChunk().
  * These functions read and write the EEPROM chunk from/to static data buffer.
@@ -42,8 +43,11 @@ class EEPROM {
 		uint16_t 		tipDataTotal(void);
 		bool			loadRecord(RECORD* config_record);
 		bool 			saveRecord(RECORD* config_record);	// Modifies the record: increment the ID and calculate CRC
+		bool			loadSchedule(PID_SCHEDULE* schedule);
+		bool			saveSchedule(PID_SCHEDULE* schedule);	// Modifies the schedule: calculate CRC
 		TIP_IO_STATUS 	loadTipData(TIP* tip, uint8_t tip_chunk_index);
-		TIP_IO_STATUS	saveTipData(TIP* tip, uint8_t tip_chunk_index);
+		TIP_IO_STATUS	saveTipData(TIP* tip, uint8_t tip_chunk_index);	// Modifies the tip: set the version and calculate CRC
+		uint8_t			upgradeTipArea(void);				// Convert the first version tip records, returns the number of converted records
 		void 			clearConfigArea(void);
 		void			forceReloadChunk(void)			{ chunk_in_data	= 65535; }
 	private:
@@ -51,6 +55,8 @@ class EEPROM {
 		bool 			writeChunk(uint16_t chunk_index);
 		uint8_t 		CFG_checkSum(RECORD* cfg, bool write);
 		uint8_t 		TIP_checkSum(TIP* tip, bool write);
+		bool			isTipChunkUpgraded(void);			// Whether the data buffer keeps the actual version tip record
+		bool			SCHED_checkSum(PID_SCHEDULE* schedule, bool write);
 		uint16_t 		requiredTipSpace(void);
 		I2C_HandleTypeDef* 	hi2c	= 0;
 		bool		can_write				= false;	// The flag indicates that data can be saved to the EEPROM
@@ -61,6 +67,8 @@ class EEPROM {
 		const uint16_t		eeprom_chunks 	= 128;		// The number of chunks in my EEPROM IC
 		const uint16_t  	eeprom_address 	= 0x50;		// AT24C32 EEPROM IC address on the I2C bus
 		const uint16_t		cfg_chunks		= 64;		// The space of EEPROM (in chunks) dedicated to the configuration data
+		const uint16_t		cfg_records		= 63;		// The chunks of the configuration area used by the configuration records
+		const uint16_t		sched_chunk		= 63;		// The chunk of the PID gain schedule
 		const uint16_t		tip_chunks		= 64;		// The maximum number of chunks used to store the configured tips
 };
 
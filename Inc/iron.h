@@ -10,19 +10,40 @@
 
 #include "pid.h"
 #include "stat.h"
+#include "ring.h"
+#include "cfgtypes.h"
+
+// The temperature and the power averaged over the sample period of the online model identification, see IRON::trackModel()
+typedef struct s_iron_sample IRON_SAMPLE;
+struct s_iron_sample {
+	int16_t		temp;										// Internal units
+	int16_t		power;
+	bool		saturated;									// The PID power reached the limits in the sample period
+};
+
+// The solder load event: the temperature estimator detected the heat taken away by the joint, see IRON::loadPulse()
+typedef struct s_iron_load IRON_LOAD;
+struct s_iron_load {
+	uint16_t	depth;										// The deepest temperature drop below the preset one, internal units
+	uint16_t	duration;									// The time the feed-forward power pulse was applied, ms
+	uint16_t	recovery;									// The time since the load was detected till the temperature returned into the band, ms
+	uint16_t	peak;										// The highest feed-forward power
+};
 
 class IRON_HW {
 	public:
 		IRON_HW(void)										{ }
 		void		init(void);
-		bool 		isIronConnected(void) 					{ return c_iron.status();						}
+		bool 		isIronConnected(void) 					{ return tc_present && c_iron.status();		}
+		bool		isCurrentLost(void)						{ return tc_present && !c_iron.status();		}	// The tip is inserted, but no current through the heater
 		uint16_t	ironCurrent(void)						{ return c_iron.read();							}	// Used in debug mode only
 		bool 		isIronTiltSwitch(void) 					{ return sw_iron.status();						}	// TRUE if switch is open
 		uint16_t	ironTilt(void)							{ return sw_iron.read();						}
 		void		updateAmbient(uint32_t value)			{ t_amb.update(value);							}
-		void		updateIronCurrent(uint16_t value)		{ c_iron.update(value);							}
-		int32_t		tempShortAverage(int32_t t)				{ return t_iron_short.average(t);				}
-		void		resetShortTemp(void)					{ t_iron_short.reset();							}
+		void		updateIronCurrent(uint16_t value);		// The current amplifier zero offset is subtracted
+		void		updateIdleCurrent(uint16_t value)		{ c_idle.update(value);							}
+		void		updateSensor(bool open);				// The thermocouple reading in the measurement window is saturated
+		uint16_t	idleCurrent(void)						{ return c_idle.read();							}	// Used in debug mode only
 		uint16_t	ambientInternal(void)					{ return t_amb.read();							}
 		bool		tiltInternal(void)						{ return sw_iron.read();						}
 		void		checkSWStatus(void);
@@ -31,15 +52,18 @@ class IRON_HW {
 	private:
 		bool		tilt_changed			= false;		// Tilt switch status changed
 		uint32_t	check_sw			= 0;				// Time when check tilt switch status (ms)
-		EMP_AVERAGE t_iron_short;							// Exponential average of the IRON temperature (short period)
 		EMP_AVERAGE t_amb;									// Exponential average of the ambient temperature
-		SWITCH 		c_iron;									// Iron is connected switch
+		SWITCH 		c_iron;									// The current flows through the IRON when it is powered
+		volatile	bool	tc_present		= false;		// The thermocouple is not open: the tip is inserted
+		uint8_t		tc_open				= 0;				// Successive measurements with the saturated thermocouple amplifier
+		EMP_AVERAGE	c_idle;									// Exponential average of the current amplifier output when the IRON is not powered
 		SWITCH 		sw_iron;								// IRON tilt switch
 		const uint8_t	ambient_emp_coeff	= 10;			// Exponential average coefficient for ambient temperature
-		const uint8_t	iron_emp_coeff		= 8;			// Exponential average coefficient for IRON temperature
 		const uint16_t	iron_off_value		= 500;
 		const uint16_t	iron_on_value		= 1000;
 		const uint8_t	iron_sw_len			= 3;			// Exponential coefficient of current through the IRON switch
+		const uint8_t	tc_open_len			= 2;			// Successive saturated measurements to detect the tip removal
+		const uint8_t	idle_emp_coeff		= 4;			// Exponential average coefficient for the current amplifier zero offset
 		const uint8_t	sw_off_value		= 14;
 		const uint8_t	sw_on_value			= 20;
 		const uint8_t	sw_avg_len			= 2;
@@ -56,32 +80,111 @@ class IRON : public IRON_HW, public PID, public PIDTUNE {
 		bool		isOn(void)								{ return (mode == POWER_ON); }
 		uint16_t 	temp(void)								{ return temp_curr; }
 		uint16_t	presetTemp(void)						{ return temp_set; }
-		uint16_t	averageTemp(void)						{ return h_temp.read(); }
+		uint16_t	averageTemp(void)						{ return temp_curr; }	// The Kalman estimate, see KALMAN
 		uint16_t 	tmpDispersion(void)						{ return d_temp.read(); }
 		uint16_t	pwrDispersion(void)              		{ return d_power.read(); }
 		uint16_t    getMaxFixedPower(void)             		{ return max_fix_power; }
 		bool		isCold(void)							{ return (mode == POWER_OFF); }
-		void     	setTemp(uint16_t t);					// Set the temperature to be kept (internal units)
+		void     	setTemp(uint16_t t, uint16_t hold = 0);	// Set the temperature to be kept (internal units) and the expected power to keep it
+		void		holdPower(uint16_t hold)				{ PID::feedForward(hold, true);	}	// Update the expected power to keep the temperature
 		uint16_t    avgPower(void);							// Average applied power
 		uint8_t     avgPowerPcnt(void);						// Power applied to the IRON in percents
 		void		fixPower(uint16_t Power);				// Set the specified power to the the soldering IRON
 		void 		adjust(uint16_t t);						// Adjust preset temperature depending on ambient temperature
-		uint16_t	power(int32_t t);						// Required power to keep preset temperature
+		uint32_t	power(int32_t t, uint8_t frac = 0, uint8_t p_frac = 0);	// Required power to keep preset temperature, t has frac extra bits, the power has p_frac fractional bits
 		void		reset(void);							// Iron is disconnected, clear the temp history
+		void		controlPeriod(uint32_t us);				// The active control period (us): PID coefficients and the averages
+		void		powerLimit(uint16_t max);				// The maximum power the hardware can apply at the active rate
+		void		schedule(const PID_SCHEDULE* s);		// Load the PID gain schedule, the schedule is not used until all the bands are tuned
+		void		useSchedule(bool on);					// Follow the gain schedule or restore the loaded PID parameters
+		void		trackInit(const PIDmodel &prior);		// New tip: the online identification and the temperature estimator start by its model
+		void		trackModel(bool on);					// Start or pause the online identification while the PID keeps the temperature
+		void		trackUpdate(void);						// Feed the estimator by the samples of the bottom half, the main loop only
+		PIDmodel	trackedModel(void)						{ return track.model();				}
+		uint8_t		trackedConfidence(void)					{ return track.confidence();		}	// Percents
+		bool		adaptPID(const PIDmodel &m, const PIDparam &base);	// Retune by the identified model unless the gain schedule is used
+		void		heatLag(int16_t lag);					// The thermal lag of the tip (ms), 0 if unknown, see heatUp()
+		bool		heatLearned(int16_t *lag);				// The thermal lag measured by the last heat-up (ms), the main loop only
+		void		loadUpdate(void);						// Log the solder load events of the bottom half, the main loop only
+		uint8_t		loadEvents(void)						{ return load_count;	}	// The number of the logged events
+		IRON_LOAD	loadEvent(uint8_t i);					// The logged event, 0 is the latest one
 	private:
+		typedef enum { HEAT_OFF, HEAT_FULL, HEAT_LAND } HeatPhase;
+		typedef enum { LOAD_OFF, LOAD_PULSE, LOAD_RECOVER } LoadPhase;
+		void		applySchedule(uint16_t t);				// Interpolate the PID coefficients for the preset temperature
+		void		trackSample(int32_t t, int32_t p);		// Average the IRON temperature and the power applied, the bottom half
+		void		heatStart(int32_t from = 0);			// Start the heat-up if the IRON is far below the preset temperature, from the warm tip temperature
+		bool		heatUp(int32_t t);						// Whether the full power should be applied, hands over to the PID otherwise
+		void		heatLand(int32_t t);					// Measure the thermal lag when the temperature settles after the heat-up
+		int32_t		holdEstimate(void);						// The power to keep the preset temperature: the learned one or by the IRON model
+		bool		isKeeping(void);						// Whether the PID keeps the preset temperature, see setTemp()
+		int32_t		reentryPower(void);						// The power the PID starts by: the measured holding power or the estimated one
+		void		reenter(void);							// Start the PID again without the bump, see reentryPower()
+		int32_t		loadPulse(int32_t t, int32_t p);		// The feed-forward power of the solder load, p is the PID power. The bottom half
 		uint16_t 	temp_set			= 0;				// The temperature that should be kept
 		uint16_t    fix_power			= 0;				// Fixed power value of the IRON (or zero if off)
 		volatile 	PowerMode	mode	= POWER_OFF;		// Working mode of the IRON
 		volatile 	bool chill			= false;			// Whether the IRON should be cooled (preset temp is lower than current)
-		volatile	uint16_t	temp_curr = 0;				// The actual IRON temperature
+		volatile	uint16_t	temp_curr = 0;				// The actual IRON temperature, estimated by the Kalman filter
+		KALMAN		est;									// The IRON temperature estimator, the bottom half only
+		PIDmodel	est_model;								// The model for the estimator, see trackInit()
+		volatile	bool	est_load	= false;			// The bottom half should load est_model
+		uint16_t	pid_limit			= 1999;				// The actual maximum power, see powerLimit()
+		PID_SCHEDULE	sched;								// The PID gain schedule, see schedule()
+		bool		sched_valid			= false;			// Whether all the bands of the gain schedule are tuned
+		bool		sched_on			= false;			// Whether the PID coefficients follow the gain schedule
+		PIDparam	sched_base;								// The PID parameters loaded before the schedule was turned on
+		RLS			track;									// The online identification of the IRON model
+		RING<IRON_SAMPLE, 4>	track_ring;					// The averaged samples from the bottom half to the main loop
+		volatile	bool	track_on	= false;			// The bottom half averages the samples
+		volatile	bool	track_start	= false;			// The bottom half should start the new average
+		int32_t		track_temp			= 0;				// The sums of the average, the bottom half only
+		int32_t		track_power			= 0;
+		uint16_t	track_count			= 0;
+		bool		track_sat			= false;			// The power reached the limits in the average
+		uint32_t	track_begin			= 0;				// The time (ms) the average started
+		uint32_t	track_lost			= 0;				// The samples lost by the ring, see trackUpdate()
+		volatile	HeatPhase	heat	= HEAT_OFF;			// The heat-up phase, see heatUp()
+		volatile	int16_t	heat_lag	= heat_lag_def;		// The thermal lag of the tip, ms
+		int32_t		heat_temp			= 0;				// The temperature and the heating slope (internal units per second) at the power cutoff
+		int32_t		heat_slope			= 0;
+		int32_t		heat_from			= 0;				// The temperature the heat-up of the warm tip started at, 0 if cold, see heatUp()
+		uint32_t	heat_cut			= 0;				// The time (ms) of the power cutoff
+		uint32_t	heat_still			= 0;				// The time (ms) the temperature rate was high last time after the cutoff
+		volatile	int16_t	heat_result	= 0;				// The thermal lag measured by the last heat-up, ms
+		volatile	bool	heat_done	= false;			// heat_result is ready for the main loop
+		int32_t		hold_power			= 0;				// The power to keep the preset temperature by the average power applied, 0 if unknown
+		volatile	LoadPhase	load_phase = LOAD_OFF;		// The solder load event phase, see loadPulse()
+		IRON_LOAD	load_event;								// The event in progress, the bottom half only
+		uint32_t	load_start			= 0;				// The time (ms) the load was detected
+		int32_t		load_fade			= 0;				// The feed-forward power, fades out when the load is gone
+		uint32_t	load_quiet			= 0;				// The last time (ms) the loss was over the threshold
+		uint8_t		load_exit			= 0;				// The number of the control periods the pulse should be finished
+		RING<IRON_LOAD, 4>	load_ring;						// The finished events from the bottom half to the main loop
+		IRON_LOAD	load_log[8];							// The latest events, circular buffer, see loadUpdate()
+		uint8_t		load_head			= 0;				// The next event to be written in load_log[]
+		uint8_t		load_count			= 0;				// The number of the events in load_log[]
 		EMP_AVERAGE h_power;								// Exponential average of applied power
-		EMP_AVERAGE	h_temp;									// Exponential average of temperature
+		EMP_AVERAGE	h_temp;									// Exponential average of temperature, the base of the temperature dispersion
 		EMP_AVERAGE d_power;								// Exponential average of power math dispersion
 		EMP_AVERAGE d_temp;									// Exponential temperature math dispersion
 		const uint16_t	max_power      		= 1999;			// Maximum power to the IRON
 		const uint16_t	max_fix_power  		= 1000;			// Maximum power in fixed power mode
 		const uint8_t	ec	   				= 20;			// Exponential average coefficient
 		const uint16_t	iron_cold			= 50;			// The internal temperature when the IRON is cold
+		static const uint16_t	track_period = 250;			// The sample period of the online identification, ms
+		static const int16_t	heat_lag_def = -600;		// The thermal lag of the unknown tip, ms
+		const uint16_t	heat_min			= 100;			// The heat-up starts if the IRON is colder than the preset temperature by this
+		const uint16_t	heat_over			= 200;			// The highest power cutoff over the preset temperature
+		const uint16_t	heat_settle			= 300;			// The temperature rate should be low this long (ms) to measure the thermal lag
+		const uint16_t	heat_timeout		= 5000;			// The longest time (ms) to wait the temperature settles after the cutoff
+		const uint16_t	heat_slope_min		= 40;			// The lowest heating slope to measure the thermal lag, internal units per second
+		const uint16_t	keep_band			= 20;			// The PID keeps the temperature if the average one is this close to the preset one
+		const uint16_t	load_min			= 200;			// The power loss that starts the load pulse, the half of it finishes the pulse
+		const uint16_t	load_band			= 13;			// The temperature has recovered inside this band (internal units, about 3 Celsius)
+		const uint16_t	load_arm			= 1000;			// The detector is armed when the loss is under the threshold this long, ms
+		const uint8_t	load_confirm		= 3;			// The pulse is finished when it should be this many control periods in a row
+		const uint16_t	load_timeout		= 30000;		// The longest recovery time to be logged, ms
 };
 
 #endif
@@ -75,16 +75,27 @@ class MWORK_IRON : public MODE, SCRSAVER {
 		void 			adjustPresetTemp(void);
 		void			hwTimeout(uint16_t low_temp, bool tilt_active);
 		void 			swTimeout(uint16_t temp, uint16_t temp_set, uint16_t temp_setH, uint32_t td, uint32_t pd, uint16_t ap, int16_t ip);
+		void			learnHoldPower(int temp, int temp_set, uint32_t td, uint32_t pd, uint16_t ap, int16_t ambient);
+		void			trackModel(void);
+		void			heatLag(void);
+		const uint8_t	ec				= 5;				// The exponential average coefficient, should be declared before idle_pwr
 		EMP_AVERAGE  	idle_pwr;							// Exponential average value for idle power
 		bool 			auto_off_notified = false;			// The time (in ms) when the automatic power-off was notified
 		bool      		ready			= false;			// Whether the IRON have reached the preset temperature
 		bool			lowpower_mode	= false;			// Whether hardware low power mode using tilt switch
 		uint32_t		ready_clear		= 0;				// Time when to clean 'Ready' message
+		uint32_t		ready_start		= 0;				// Time when the IRON started to reach the preset temperature
+		uint32_t		ready_time		= 0;				// The time to reach the preset temperature (ms) to be shown after 'Ready' message
 		uint32_t		lowpower_time	= 0;				// Time when switch to standby power mode
 		uint16_t		preset_temp		= 0;				// The preset temperature
 		uint16_t 		old_temp_set	= 0;
+		uint32_t		hold_sum		= 0;				// The power summary to learn the holding power model, see learnHoldPower()
+		uint8_t			hold_loops		= 0;				// The number of stable power readings in hold_sum
+		bool			hold_learned	= false;			// The holding power model was learned for the preset temperature
+		bool			model_saved		= false;			// The IRON model identified online was saved in this session, see trackModel()
 		const uint16_t	period			= 500;				// Redraw display period (ms)
-		const uint8_t	ec				= 5;				// The exponential average coefficient
+		const uint8_t	hold_learn_loops = 20;				// Stable power readings to learn the holding power model (10 seconds)
+		const uint8_t	track_confidence = 80;				// The confidence of the identified model to use it, percents
 };
 
 //---------------------- The boost mode, shortly increase the temperature --------
@@ -141,10 +152,11 @@ class MMENU : public MODE {
 		bool		buzzer			= true;					// Whether the buzzer is enabled
 		bool		celsius			= true;					// Temperature units: C/F
 		bool		reed			= false;
+		bool		adapt			= false;				// Whether the PID follows the IRON model identified online
 		uint8_t		set_param		= 0;					// The index of the modifying parameter
-		uint8_t		m_len			= 16;					// The menu length
+		uint8_t		m_len			= 17;					// The menu length
 		uint8_t		mode_menu_item 	= 1;					// Save active menu element index to return back later
-		const char* menu_name[16] = {
+		const char* menu_name[17] = {
 			"boost setup",
 			"units",
 			"buzzer",
@@ -160,6 +172,7 @@ class MMENU : public MODE {
 			"tune",
 			"reset config",
 			"tune PID",
+			"adaptive PID",
 			"about"
 		};
 		const uint16_t	min_standby_C	= 120;				// Minimum standby temperature, Celsius
@@ -169,16 +182,18 @@ class MMENU : public MODE {
 //---------------------- Calibrate tip menu --------------------------------------
 class MCALMENU : public MODE {
 	public:
-		MCALMENU(HW* pCore, MODE* cal_auto, MODE* cal_manual);
+		MCALMENU(HW* pCore, MODE* cal_auto, MODE* cal_manual, MODE* cal_settle);
 		virtual void	init(void);
 		virtual MODE*	loop(void);
 	private:
 		MODE*			mode_calibrate_tip;
 		MODE*			mode_calibrate_tip_manual;
-		uint8_t  		old_item = 4;
-		const char* menu_list[4] = {
+		MODE*			mode_calibrate_settle;
+		uint8_t  		old_item = 5;
+		const char* menu_list[5] = {
 			"automatic",
 			"manual",
+			"settle time",
 			"clear",
 			"exit"
 		};
@@ -222,6 +237,16 @@ class MCALIB_MANUAL : public MODE {
 		uint16_t	fan_speed		= 1500;					// The Hot Air Gun fan speed during calibration
 };
 
+//---------------------- The amplifier settle time calibration mode -------------
+class MSETTLE : public MODE {
+	public:
+		MSETTLE(HW *pCore) : MODE(pCore)					{ }
+		virtual void	init(void);
+		virtual MODE*	loop(void);
+	private:
+		bool		started			= false;				// Whether the measurement has been started
+};
+
 //---------------------- The Boost setup menu mode -------------------------------
 class MMBST : public MODE {
 	public:
@@ -266,7 +291,7 @@ class MTPID : public MODE {
 		uint8_t		data_index	= 0;						// Active coefficient
 		bool        modify		= 0;						// Whether is modifying value of coefficient
 		bool		on			= 0;						// Whether the IRON is turned on
-		uint16_t 	old_index 	= 3;
+		uint16_t 	old_index 	= 5;
 };
 
 //---------------------- The PID coefficients automatic tune mode ----------------
@@ -278,6 +303,8 @@ class MAUTOPID : public MODE {
 		virtual MODE*	loop(void);
 		bool			updatePID(void);
 	private:
+		void		bandStart(void);						// Heat the IRON to the reference temperature of the active band
+		bool		bandTuned(void);						// Save the tuned coefficients of the band, true when all the bands are tuned
 		uint32_t	data_update	= 0;						// When read the data from the sensors (ms)
 		uint32_t	next_mode	= 0;						// When next mode can be activated (ms)
 		uint16_t	base_pwr	= 0;						// The applied power when preset temperature reached
@@ -287,7 +314,11 @@ class MAUTOPID : public MODE {
 		uint16_t	data_period = 250;						// Graph data update period (ms)
 		TuneMode	mode		= TUNE_OFF;					// The preset temperature reached
 		uint16_t	tune_loops	= 0;						// The number of oscillation loops elapsed in relay mode
+		bool		tip_only	= false;					// Tune the current tip only, see CFG::saveTipPID()
+		uint8_t		band		= 0;						// The band of the PID gain schedule being tuned
+		PID_SCHEDULE	schedule;							// The PID gain schedule being tuned
 		const uint16_t	max_delta_temp 		= 20;			// Maximum possible temperature difference between base_temp and upper temp.
+		const uint16_t	band_temp[PID_BANDS] = {200, 300, 400};	// The reference temperatures of the bands (Celsius)
 };
 
 //---------------------- The Fail mode: display error message --------------------
@@ -314,6 +345,7 @@ class MDEBUG : public MODE {
 		virtual MODE*	loop(void);
 	private:
 		uint16_t		old_power 		= 0;
+		uint8_t			page			= 0;				// 0 - raw data, 1 - the ADC data processing timing, 2 - the solder load events
 		const uint16_t	max_iron_power 	= 300;
 };
 
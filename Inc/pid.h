@@ -12,13 +12,246 @@
 #include "stat.h"
 #include "vars.h"
 
+/*
+ * The PID coefficients and the setpoint weights of the proportional (b) and derivative (c) terms in 1/weight_one units.
+ * b = 1, c = 0 - the classic PID with the derivative on the measurement, b = 0, c = 0 - all the setpoint changes go through the integral term
+ */
 class PIDparam {
 	public:
-		PIDparam(int32_t Kp = 0, int32_t Ki = 0, int32_t Kd = 0);
+		PIDparam(int32_t Kp = 0, int32_t Ki = 0, int32_t Kd = 0, uint8_t b = weight_one, uint8_t c = 0);
 		PIDparam(const PIDparam &p);
 		int32_t	Kp					= 0;
 		int32_t	Ki					= 0;
 		int32_t	Kd					= 0;
+		uint8_t	b					= weight_one;
+		uint8_t	c					= 0;
+		static const uint8_t	weight_one = 10;			// The setpoint weight 1.0
+};
+
+/*
+ * The first order plus dead time model of the IRON: tau * dY/dt = gain * U(t - dead) - Y
+ * where Y is the temperature over ambient (internal units, the internal reading is zero at ambient temperature) and U is the power.
+ * The model is identified by the relay method, see PID::identify()
+ */
+class PIDmodel {
+	public:
+		PIDmodel(uint16_t gain = 0, uint16_t tau = 0, uint16_t dead = 0) : gain(gain), tau(tau), dead(dead)	{ }
+		bool		isValid(void) const						{ return gain && tau && dead;	}
+		static PIDmodel	typical(void)						{ return PIDmodel(800, 50000, 530);	}	// The typical T12 tip, the default model
+		uint16_t	gain			= 0;					// The static gain, internal units per power unit, 8 fractional bits
+		uint16_t	tau				= 0;					// The time constant, ms
+		uint16_t	dead			= 0;					// The dead time, ms
+};
+
+/*
+ * The Smith predictor: the PID gets the measured temperature corrected by the model output that has not reached the sensor yet
+ *    Xc = Xn + Yn - Yn-d
+ * where Y is the model output without the dead time (see PIDmodel) and d is the dead time in control periods.
+ * The PID controls the delay free model, the model errors are corrected by the feedback. The correction fades in the steady state,
+ * so the static gain of the model does not shift the temperature.
+ */
+class SMITH {
+	public:
+		SMITH(void)											{ }
+		void		model(const PIDmodel &m, uint32_t period_us);	// The model for the control period, the invalid model switches the predictor off
+		void		reset(void);
+		bool		isOn(void)								{ return on;	}
+		int16_t		correction(void)						{ return (y[head] - y[(uint8_t)(head - delay) & (delay_max-1)] + 128) >> 8;	}
+		void		update(int32_t power);					// The power applied, integer
+	private:
+		static const uint8_t	delay_max	= 128;			// The longest dead time, control periods. Should be a power of 2
+		int32_t		y[delay_max]	= {0};					// The model output history, 8 fractional bits
+		uint8_t		head			= 0;					// The latest model output
+		uint8_t		delay			= 0;					// The dead time, control periods
+		int32_t		gain			= 0;					// The static gain, 8 fractional bits
+		int32_t		alpha			= 0;					// The control period to the time constant ratio, 16 fractional bits
+		bool		on				= false;
+};
+
+/*
+ * The online identification of the IRON model by the recursive least squares with forgetting.
+ * The temperature over ambient and the power averaged over the sample period make the first order ARX model:
+ *    Yk = a*Yk-1 + b*Uk-d
+ * d is the dead time in sample periods. The dead time is not identifiable while the IRON keeps the temperature,
+ * it is taken from the prior model (the relay tune) or the default one. The model has no constant term: the holding power
+ * ties the static gain, otherwise the gain is not identifiable in the closed loop that keeps the temperature constant.
+ *    gain = b / (1 - a); tau = -T / ln(a)
+ * The old data are forgotten in the direction of the new regressor only (the directional forgetting), so the model
+ * does not wander while the IRON just keeps the temperature: the constant temperature and power tie the gain, not the time constant.
+ * The confidence is 100% less the biggest relative uncertainty of the gain and the time constant: the standard deviation
+ * estimated by the covariance and the prediction error or the deviation from the slow average of the estimates.
+ * The last one takes the model error: the T12 tip is not exactly the first order, so the estimates move while
+ * the fast heater node or the slow tip body dominates.
+ * The estimator runs in the main loop at the sample rate, so the double precision is affordable
+ */
+class RLS {
+	public:
+		RLS(void)											{ }
+		void		init(const PIDmodel &prior, uint16_t period_ms);	// Start by the prior model, the invalid one is replaced by the default one
+		void		restart(void)							{ filled = 0;	}	// Clear the signal history after a pause, keep the model
+		void		update(int16_t temp, int16_t power);	// The averages of the sample period: internal temperature and power
+		PIDmodel	model(void);							// The identified model, invalid if it has no physical sense
+		uint8_t		confidence(void)						{ return conf;	}	// Percents
+	private:
+		void		evaluate(void);							// Update the confidence
+		static const uint8_t	hist_len	= 8;			// The longest dead time, sample periods. Should be a power of 2
+		static const uint16_t	min_samples	= 40;			// The updates before the confidence is evaluated
+		static const uint8_t	drift_len	= 128;			// The length of the slow average of the estimates, sample periods
+		double		theta[2]		= {0};					// a, b; the signals are scaled by 1/scale
+		double		P[2][2]			= {{0}};				// The parameter covariance (not scaled by the noise variance)
+		double		err2			= 0;					// The exponential average of the squared prediction error
+		double		gain_avg		= 0;					// The slow exponential averages of the gain and the time constant
+		double		tau_avg			= 0;
+		int16_t		u[hist_len]		= {0};					// The power history
+		int16_t		y_prev			= 0;
+		uint8_t		head			= 0;					// The latest power in u[]
+		uint8_t		filled			= 0;					// The number of valid elements in the history
+		uint8_t		delay			= 1;					// d, sample periods
+		uint16_t	period			= 250;					// The sample period, ms
+		uint16_t	dead			= 0;					// The dead time of the model, ms
+		uint16_t	n				= 0;					// The number of updates since init, saturated
+		uint8_t		conf			= 0;
+		const double	p_prior		= 0.01;					// The initial covariance of the prior model and the default one
+		const double	p_default	= 1.0;
+		const double	lambda		= 0.995;				// The forgetting factor, the memory is about 1/(1-lambda) samples
+		const double	scale		= 1024.0;				// The signal scale, keeps the regressors about 1
+};
+
+#ifndef PID_Q
+#define PID_Q		(16)									// The fractional bits of the PID engine accumulators, see PIDQ
+#endif
+
+/*
+ * The fixed-point PID engine in the positional form:
+ *    e  = Xs - Xn
+ *    Dn = Dn-1 + (Kd*(c*(Xs - Xs-1) - (Xn - Xn-1)) - Dn-1) / 2^DF	The derivative with the first order low-pass filter
+ *    Un = Kp*e + In-1 + Ki*e - Kp*(1-b)*(Xs - Xs-1) + Dn + F	F - the feed-forward power, see feedForward()
+ *    In = In-1 + Ki*e - Kp*(1-b)*(Xs - Xs-1) + (sat(Un) - Un) / 2^AW	The back-calculation anti-windup, sat() - the actuator limits
+ *  With the first step: In-1 = 0; Dn-1 = 0; Xn-1 = Xn; Xs-1 = Xs
+ * The setpoint weights b and c (see PIDparam) make the two degrees of freedom PID: the proportional term is Kp*(b*Xs - Xn)
+ * and the derivative term is Kd*d(c*Xs - Xn)/dt. The constant part -Kp*(1-b)*Xs is kept in the integral term,
+ * so only the setpoint change is weighted, and the output does not depend on b while the setpoint is constant.
+ * While the setup temperature is constant, it is the same law as the interactive formula of PID below,
+ * but the integral term cannot wind up past the actuator limits: it tracks the actual output with the time constant 2^AW periods.
+ * The derivative filter time constant is about 2^DF - 1 periods. All the terms are kept with Q fractional bits
+ * in 64-bit accumulators, the products of the 32-bit gains and 16-bit temperatures cannot overflow.
+ */
+template <uint8_t Q, uint8_t DF = 1, uint8_t AW = 1>
+class PIDQ {
+	public:
+		PIDQ(void)											{ }
+		void		gains(int32_t kp, int32_t ki, int32_t kd, uint8_t gain_frac);	// The gains with gain_frac fractional bits, bumpless
+		void		limits(int32_t low, int32_t high);		// The actuator limits, integer power
+		void		weights(uint8_t b, uint8_t c)			{ w_b = b; w_c = c;	}	// The setpoint weights, see PIDparam
+		void		feedForward(int32_t power, bool bumpless = false);	// The expected power to keep the temperature, integer power
+		void		reset(void)								{ first = true; preset = false;				}
+		void		preload(int32_t power)					{ first = true; preset = true; start = (int64_t)power << Q;	}	// Reset, the integral and the feed-forward terms start at the power
+		void		transfer(int32_t power);				// Bumpless transfer: the last output becomes the power, the history is kept
+		int32_t		update(int16_t temp_set, int16_t temp_curr, uint8_t frac = 0);	// The power has frac fractional bits
+	private:
+		static_assert(Q >= 8 && Q <= 30, "The PID engine accumulators should have 8...30 fractional bits");
+		int64_t		toQ(int64_t v, uint8_t v_frac)			{ return (v_frac <= Q)?(v << (Q - v_frac)):(v >> (v_frac - Q)); }
+		int32_t		kp			= 0;						// The gains
+		int32_t		ki			= 0;
+		int32_t		kd			= 0;
+		uint8_t		k_frac		= 0;						// The gains fractional bits
+		uint8_t		w_b			= PIDparam::weight_one;		// The setpoint weights
+		uint8_t		w_c			= 0;
+		int64_t		u_min		= 0;						// The actuator limits, Q format
+		int64_t		u_max		= 0;
+		int64_t		integral	= 0;						// The integral term, Q format
+		int64_t		derivative	= 0;						// The filtered derivative term, Q format
+		int64_t		forward		= 0;						// The feed-forward term, Q format
+		int64_t		start		= 0;						// The integral and the feed-forward terms after preload(), Q format
+		int16_t		temp_prev	= 0;						// The previously measured temperature
+		int16_t		set_prev	= 0;						// The previous setup temperature
+		bool		first		= true;						// No history, see reset()
+		bool		preset		= false;					// The integral term starts at start - forward, see preload()
+};
+
+template <uint8_t Q, uint8_t DF, uint8_t AW>
+void PIDQ<Q, DF, AW>::gains(int32_t kp, int32_t ki, int32_t kd, uint8_t gain_frac) {
+	if (!first) {											// The integral term takes the proportional term change on the last error
+		int32_t e	= set_prev - temp_prev;
+		integral	+= toQ((int64_t)this->kp * e, k_frac) - toQ((int64_t)kp * e, gain_frac);
+	}
+	this->kp	= kp;
+	this->ki	= ki;
+	this->kd	= kd;
+	k_frac		= gain_frac;
+}
+
+template <uint8_t Q, uint8_t DF, uint8_t AW>
+void PIDQ<Q, DF, AW>::limits(int32_t low, int32_t high) {
+	u_min	= (int64_t)low  << Q;
+	u_max	= (int64_t)high << Q;
+}
+
+// If bumpless, the integral term takes the feed-forward change, so the output does not jump when the model is updated on the fly
+template <uint8_t Q, uint8_t DF, uint8_t AW>
+void PIDQ<Q, DF, AW>::feedForward(int32_t power, bool bumpless) {
+	int64_t f = (int64_t)power << Q;
+	if (bumpless && !first)
+		integral -= f - forward;
+	forward = f;
+}
+
+/*
+ * The integral term takes the difference between the last output and the power, so the next output starts at the power
+ * and then goes by the new error only: the setpoint change is weighted as usual. Without the history it is preload()
+ */
+template <uint8_t Q, uint8_t DF, uint8_t AW>
+void PIDQ<Q, DF, AW>::transfer(int32_t power) {
+	if (first) {
+		preload(power);
+		return;
+	}
+	integral = ((int64_t)power << Q) - forward - toQ((int64_t)kp * (set_prev - temp_prev), k_frac) - derivative;
+}
+
+template <uint8_t Q, uint8_t DF, uint8_t AW>
+int32_t PIDQ<Q, DF, AW>::update(int16_t temp_set, int16_t temp_curr, uint8_t frac) {
+	if (first) {
+		integral	= preset?(start - forward):0;
+		preset		= false;
+		derivative	= 0;
+		temp_prev	= temp_curr;
+		set_prev	= temp_set;
+		first		= false;
+	}
+	int32_t e		= temp_set - temp_curr;
+	int32_t ds		= temp_set - set_prev;					// The setpoint change, weighted
+	int64_t i		= integral + toQ((int64_t)ki * e, k_frac);
+	int64_t d_raw	= toQ(-(int64_t)kd * (temp_curr - temp_prev), k_frac);
+	if (ds) {
+		i			-= toQ((int64_t)kp * ds * (PIDparam::weight_one - w_b) / PIDparam::weight_one, k_frac);
+		d_raw		+= toQ((int64_t)kd * ds * w_c / PIDparam::weight_one, k_frac);
+		set_prev	= temp_set;
+	}
+	derivative		+= (d_raw - derivative) >> DF;
+	temp_prev		= temp_curr;
+	int64_t u		= toQ((int64_t)kp * e, k_frac) + i + derivative + forward;
+	int64_t u_sat	= u;
+	if (u_sat > u_max) u_sat = u_max;
+	if (u_sat < u_min) u_sat = u_min;
+	integral		= i + ((u_sat - u) >> AW);				// Back-calculation: unwind the integral by the excess of the actuator limits
+	if (frac >= Q) frac = Q - 1;
+	uint8_t shift	= Q - frac;								// Keep frac bits of the fraction part
+	return (int32_t)((u_sat + (1LL << (shift-1))) >> shift);
+}
+
+/*
+ * The main loop changes the PID engine state that the bottom half (PendSV_Handler) updates every control period.
+ * The 64-bit terms take two words on the Cortex-M3, so the PendSV exception (the lowest priority, see HAL_MspInit())
+ * is masked while the main loop changes them. The other interrupts are served. The lock can be nested and taken in the bottom half
+ */
+class PID_LOCK {
+	public:
+		PID_LOCK(void)										{ basepri = __get_BASEPRI(); __set_BASEPRI_MAX(pendsv_prio << (8 - __NVIC_PRIO_BITS));	}
+		~PID_LOCK(void)										{ __set_BASEPRI(basepri);	}
+	private:
+		uint32_t	basepri;
+		static const uint32_t	pendsv_prio	= 15;
 };
 
 /*  The PID algorithm 
@@ -30,18 +263,40 @@ class PIDparam {
  *  U0 = Kp*(Xs - X0) + Ki*(Xs - X0); Xn-1 = Xn;
  *  
  *  The default values of PID coefficients can be found in config.cpp
+ *  The coefficients are defined for the reference control period (ref_period). When the control period changes,
+ *  the integral and the derivative coefficients are scaled: Ki*T/Tref, Kd*Tref/T, see controlPeriod()
+ *
+ *  The interactive formula keeps the power beyond the actuator limits and has no derivative filter,
+ *  so by default the power is calculated by the PIDQ engine with the same coefficients.
+ *  Define PID_V1 to build the interactive formula (the twin benchmark compares both, see host/Src/bench.cpp).
+ *  The interactive formula has the proportional and derivative terms on the measurement, the setpoint weights are not used
  */
 class PID {
 	public:
 		PID(void) 											{ }
 		void		load(const PIDparam &p);
-		PIDparam	dump(void)								{ return PIDparam(Kp, Ki, Kd);	}
+		void		retune(int32_t Kp, int32_t Ki, int32_t Kd);	// Change the coefficients on the fly, keep the setpoint weights
+		PIDparam	dump(void)								{ return PIDparam(Kp, Ki, Kd, Kb, Kc);	}
 		void		init(uint8_t denominator_p = 11);
 		void 		resetPID(void);        					// reset PID algorithm history parameters
-		int32_t 	reqPower(int16_t temp_set, int16_t temp_curr);
-		int32_t  	changePID(uint8_t p, int32_t k);    	// set or get (if parameter < 0) PID parameter
+		int32_t 	reqPower(int16_t temp_set, int16_t temp_curr, uint8_t frac = 0);	// The power has frac fractional bits
+		int32_t  	changePID(uint8_t p, int32_t k);    	// set or get (if parameter < 0) PID parameter: Kp, Ki, Kd, b, c
 		void		newPIDparams(uint16_t delta_power, uint32_t diff, uint32_t period);
+		void		controlPeriod(uint32_t us);				// Set the active control period, us
+		void		powerLimits(int32_t low, int32_t high);	// The actuator limits of the power, the anti-windup of the PID engine
+		void		feedForward(int32_t power, bool bumpless = false);	// The expected power to keep the temperature, the PID corrects the residual
+		int32_t		forward(void)							{ return ff_power;	}	// The feed-forward power, 0 if unknown
+		void		preload(int32_t power);					// Reset the history, the integral term starts so that the output is the power
+		void		transfer(int32_t power);				// Keep the history, the integral term changes so that the output is the power
+		void		model(const PIDmodel &m, bool predictor);	// The IRON model, use the Smith predictor if predictor is true
+		void		modelPIDparams(const PIDmodel &m, bool predictor);	// Build the coefficients by the IRON model
+		bool		adapt(const PIDmodel &m, const PIDparam &base);	// Retune by the model identified online within the base coefficients range
+		static PIDmodel	identify(uint16_t base_power, uint16_t base_temp, uint16_t delta_power, uint16_t alpha, uint16_t epsilon, uint32_t period);
+		static const uint32_t	ref_period	= 20833;		// The control period the coefficients are defined for (48 Hz), us
 	private:
+		int32_t		control(int16_t temp_set, int16_t temp_curr, uint8_t frac);
+		PIDparam	modelParams(const PIDmodel &m, bool predictor);	// The coefficients by the IRON model, see modelPIDparams()
+		void		scale(void);							// Build the coefficients for the active control period
 		void  		debugPID(int t_set, int t_curr, long kp, long ki, long kd, long delta_p);
 		int16_t   	temp_h0			= 0;					// previously measured temperatures
 		int16_t	  	temp_h1			= 0;
@@ -50,7 +305,72 @@ class PID {
 		int32_t  	Kp 				= 10;					// The PID coefficients multiplied by denominator.
 		int32_t     Ki 				= 10;
 		int32_t		Kd				= 0;
+		uint8_t		Kb				= PIDparam::weight_one;	// The setpoint weights, see PIDparam
+		uint8_t		Kc				= 0;
+		int32_t		ki_t			= 10;					// Ki and Kd scaled to the active control period
+		int32_t		kd_t			= 0;
+		uint32_t	period_us		= ref_period;			// The active control period, us
+		int32_t		ff_power		= 0;					// The feed-forward power, see feedForward()
+		int32_t		i_start			= 0;					// The integral term of the direct formula steps, see preload()
+		int32_t		pwr_low			= 0;					// The actuator limits, see powerLimits()
+		int32_t		pwr_high		= 0x7FFF;
+		PIDmodel	fopdt;									// The IRON model, see model()
+		SMITH		smith;
 		int16_t  	denominator_p	= 11;              		// The common coefficient denominator power of 2 (11 means 2048)
+#ifndef PID_V1
+		PIDQ<PID_Q>	engine;
+#endif
+};
+
+/*
+ * The Kalman filter of the IRON temperature: the model predicts the temperature by the power applied, the measurement corrects it.
+ * The state is the temperature Y and the drift D, the temperature change per control period the model does not explain
+ * (the error of the model, the fast heater node, the solder load):
+ *    Yn = Yn-1 + alpha*(gain*Un-1-d - Yn-1) + Dn-1;	Dn = Dn-1
+ * where alpha is the control period to the time constant ratio and d is the dead time in control periods, see PIDmodel.
+ * The ambient is zero in the internal units, so the model needs the power only. Then the Kalman gains correct the prediction:
+ *    Yn += Kt*(Xn - Yn);	Dn += Kd*(Xn - Yn)
+ * The drift is a random walk, so the estimate follows the temperature ramp without the lag of the exponential average,
+ * and the model takes the power changes before the measurement shows them. The noise variances are defined for the reference
+ * control period (PID::ref_period) and scaled to the active one. The measurement that jumps out of any prediction
+ * (the new tip inserted) restarts the filter.
+ * Fixed point: the state has 16 fractional bits, the covariance (internal units squared) 24 bits, the gains and alpha 24 bits
+ */
+class KALMAN {
+	public:
+		KALMAN(void)										{ }
+		void		model(const PIDmodel &m);				// The invalid model is replaced by the typical one
+		void		controlPeriod(uint32_t us);				// The active control period, us
+		void		reset(void)								{ first = true;	}
+		int32_t		update(int32_t t, uint8_t frac = 0);	// Correct by the temperature t with frac extra bits, returns the estimate (internal units)
+		int32_t		rate(void);								// The temperature change predicted for the next period, internal units per second
+		int32_t		loss(void);								// The power the model does not explain (the drift), integer power
+		void		resetDrift(void)						{ drift = 0;	}	// The disturbance is gone, the drift is late to follow it
+		void		predict(int32_t power);					// The power applied in this control period, integer
+	private:
+		void		scale(void);							// alpha, the dead time and the process noise for the active control period
+		static const uint8_t	hist_len	= 128;			// The longest dead time, control periods. Should be a power of 2
+		int16_t		u[hist_len]		= {0};					// The power history
+		uint8_t		head			= 0;					// The latest power in u[]
+		uint8_t		delay			= 1;					// d, control periods
+		int32_t		temp			= 0;					// Y, 16 fractional bits
+		int32_t		drift			= 0;					// D, 16 fractional bits
+		int64_t		p_tt			= 0;					// The covariance of the state, 24 fractional bits
+		int64_t		p_td			= 0;
+		int64_t		p_dd			= 0;
+		int64_t		q_t				= 0;					// The process noise of the temperature and the drift at the active control period
+		int64_t		q_d				= 0;
+		int32_t		alpha			= 0;					// 24 fractional bits
+		uint16_t	gain			= 0;					// The model, see PIDmodel
+		uint16_t	tau				= 0;
+		uint16_t	dead			= 0;
+		uint32_t	period_us		= PID::ref_period;		// The active control period
+		bool		first			= true;					// The next measurement starts the filter
+		const int64_t	r_noise		= 1LL << 24;			// The measurement noise variance: 1 internal unit squared
+		const int64_t	q_temp		= 1LL << 14;			// The process noise variances for the reference control period
+		const int64_t	q_drift		= 1LL << 8;
+		const int64_t	p_drift		= 1LL << 24;			// The initial variance of the drift
+		const int32_t	jump		= 100;					// The measurement out of the prediction by this restarts the filter, internal units
 };
 
 class PIDTUNE {
@@ -0,0 +1,62 @@
+/*
+ * ring.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Lock-free single producer, single consumer ring buffer
+ */
+
+#ifndef RING_H_
+#define RING_H_
+
+#include "main.h"
+
+/*
+ * The producer (an interrupt handler) writes the element, then publishes it by advancing head.
+ * The consumer (the main loop) copies the element, then frees it by advancing tail.
+ * Each index is written by one side only, so neither side has to disable interrupts.
+ * The indexes are free-running, the number of elements is head - tail. N should be a power of 2.
+ * When the ring is full, the new element is dropped and counted: the elements already queued are never lost.
+ */
+template <typename T, uint16_t N>
+class RING {
+	public:
+		RING(void)											{ }
+		bool		push(const T& item);					// Producer only
+		bool		pop(T* item);							// Consumer only
+		uint16_t	size(void)								{ return (uint16_t)(head - tail);	}
+		uint32_t	overrun(void)							{ return lost;						}	// Elements dropped because the ring was full
+		void		clear(void)								{ tail = head;						}	// Consumer only
+	private:
+		static_assert((N & (N - 1)) == 0, "The ring size should be a power of 2");
+		T					data[N];
+		volatile uint16_t	head	= 0;					// The next element to be written, changed by the producer
+		volatile uint16_t	tail	= 0;					// The next element to be read, changed by the consumer
+		volatile uint32_t	lost	= 0;
+};
+
+template <typename T, uint16_t N>
+bool RING<T, N>::push(const T& item) {
+	uint16_t h = head;
+	if ((uint16_t)(h - tail) >= N) {
+		++lost;
+		return false;
+	}
+	data[h & (N - 1)] = item;
+	__DMB();												// The element is written before it is published
+	head = h + 1;
+	return true;
+}
+
+template <typename T, uint16_t N>
+bool RING<T, N>::pop(T* item) {
+	uint16_t t = tail;
+	if (t == head) return false;
+	__DMB();												// Read the element published by the producer
+	*item = data[t & (N - 1)];
+	__DMB();												// The element is read before it is freed
+	tail = t + 1;
+	return true;
+}
+
+#endif /* RING_H_ */
@@ -17,6 +17,8 @@ class EMP_AVERAGE {
 		EMP_AVERAGE(uint8_t h_length = 8)				{ emp_k = h_length; emp_data = 0; }
 		void			length(uint8_t h_length)		{ emp_k = h_length; emp_data = 0; }
 		void			reset(void)						{ emp_data = 0; }
+		void			rescale(uint8_t h_length);		// Change the length keeping the average value
+		void			preset(int32_t value)			{ emp_data = value * emp_k; }	// Fill the history with the value
 		int32_t			average(int32_t value);
 		void			update(int32_t value);
 		int32_t			read(void);
@@ -49,6 +51,7 @@ class SWITCH : public EMP_AVERAGE {
         void        init(uint8_t h_len, uint16_t on = 500, uint16_t off = 500);
         bool        status(void);
         void		update(uint16_t value);
+        void		set(bool on);							// Force the switch status
     private:
         bool        mode	 = false;               		// The switch mode on (true)/off
         int16_t    	on_val  = 500;                 			// Turn on  value
@@ -30,6 +30,7 @@ CFG_STATUS CFG::init(void) {
 	uint8_t tips_loaded = 0;
 
 	if (EEPROM::init()) {
+		upgradeTipArea();									// Convert the tip records saved by the previous version
 		if (tip_table) {
 			tips_loaded = buildTipTable(tip_table);
 		}
@@ -60,6 +61,11 @@ bool CFG::selectTip(uint8_t index) {
 	if (!tip_table) return false;
 	bool result = true;
 	uint8_t tip_chunk_index = tip_table[index].tip_chunk_index;
+	TIP_CFG::hold 		= 0;
+	TIP_CFG::tip_pid	= false;
+	TIP_CFG::model		= PIDmodel();
+	TIP_CFG::smith		= false;
+	TIP_CFG::lag		= 0;
 	if (tip_chunk_index == NO_TIP_CHUNK) {
 		TIP_CFG::defaultCalibration();
 		return false;
@@ -69,6 +75,14 @@ bool CFG::selectTip(uint8_t index) {
 		TIP_CFG::defaultCalibration();
 		result = false;
 	} else {
+		TIP_CFG::hold = tip.hold;							// The holding power model and the PID do not depend on the calibration status
+		TIP_CFG::model		= PIDmodel(tip.model_gain, tip.model_tau, tip.model_dead);
+		TIP_CFG::lag		= tip.lag;
+		if (tip.mask & TIP_PID) {
+			TIP_CFG::tip_pid	= true;
+			TIP_CFG::pid		= unpackPID(tip.pid_Kp, tip.pid_Ki, tip.pid_Kd, tip.pid_weight);
+			TIP_CFG::smith		= tip.mask & TIP_SMITH;
+		}
 		if (!(tip.mask & TIP_CALIBRATED)) {					// Tip is not calibrated, load default config
 			TIP_CFG::defaultCalibration();
 		} else if (!isValidTipConfig(&tip)) {
@@ -179,13 +193,123 @@ void CFG::savePID(PIDparam &pp) {
 	a_cfg.pid_Kp	= pp.Kp;
 	a_cfg.pid_Ki	= pp.Ki;
 	a_cfg.pid_Kd	= pp.Kd;
+	a_cfg.pid_weight = packWeights(pp);
 	saveRecord(&a_cfg);
 	CFG_CORE::syncConfig();
 }
 
-// Save new IRON tip calibration data to the EEPROM only. Do not change active configuration
+// The PID parameters of the current tip if the tip was tuned, see saveTipPID(), otherwise the common PID parameters
+PIDparam CFG::pidParams(void) {
+	if (TIP_CFG::tip_pid)
+		return TIP_CFG::pid;
+	return CFG_CORE::pidParams();
+}
+
+// Save the PID parameters of the current tip and the IRON model. The tip should be in the EEPROM, i.e. activated
+bool CFG::saveTipPID(PIDparam &pp, const PIDmodel *m, bool smith) {
+	if (!tip_table || gun_mode) return false;
+	uint8_t tip_chunk_index = tip_table[a_cfg.tip].tip_chunk_index;
+	if (tip_chunk_index == NO_TIP_CHUNK) return false;
+	TIP tip;
+	if (loadTipData(&tip, tip_chunk_index) != EPR_OK) return false;
+	tip.mask		|= TIP_PID;
+	tip.pid_Kp		= constrain(pp.Kp, 0, 0xFFFF);
+	tip.pid_Ki		= constrain(pp.Ki, 0, 0xFFFF);
+	tip.pid_Kd		= constrain(pp.Kd, 0, 0xFFFF);
+	tip.pid_weight	= packWeights(pp);
+	if (m) {
+		tip.model_gain	= m->gain;
+		tip.model_tau	= m->tau;
+		tip.model_dead	= m->dead;
+		tip.mask		&= ~TIP_SMITH;
+		if (smith && m->isValid()) tip.mask |= TIP_SMITH;
+	}
+	if (saveTipData(&tip, tip_chunk_index) != EPR_OK) return false;
+	tip_table[a_cfg.tip].tip_mask = tip.mask;
+	TIP_CFG::tip_pid	= true;
+	TIP_CFG::pid		= unpackPID(tip.pid_Kp, tip.pid_Ki, tip.pid_Kd, tip.pid_weight);
+	TIP_CFG::model		= PIDmodel(tip.model_gain, tip.model_tau, tip.model_dead);
+	TIP_CFG::smith		= tip.mask & TIP_SMITH;
+	return true;
+}
+
+/*
+ * Save the IRON model of the current tip identified online, see RLS. The EEPROM is written only if the model has changed.
+ * If the tip is not in the EEPROM, the model is kept till the tip is changed
+ */
+bool CFG::saveTipModel(const PIDmodel &m) {
+	if (!m.isValid()) return false;
+	TIP_CFG::model = m;
+	if (!tip_table || gun_mode) return false;
+	uint8_t tip_chunk_index = tip_table[a_cfg.tip].tip_chunk_index;
+	if (tip_chunk_index == NO_TIP_CHUNK) return false;
+	TIP tip;
+	if (loadTipData(&tip, tip_chunk_index) != EPR_OK) return false;
+	if (tip.model_gain == m.gain && tip.model_tau == m.tau && tip.model_dead == m.dead) return true;
+	tip.model_gain	= m.gain;
+	tip.model_tau	= m.tau;
+	tip.model_dead	= m.dead;
+	return (saveTipData(&tip, tip_chunk_index) == EPR_OK);
+}
+
+/*
+ * Save the thermal lag of the current tip, see TIP. The EEPROM is written only if the lag has changed.
+ * If the tip is not in the EEPROM, the lag is kept till the tip is changed
+ */
+bool CFG::saveTipLag(int16_t lag) {
+	int16_t l = constrain((lag + (lag < 0?-10:10)) / 20, -INT8_MAX, INT8_MAX);
+	if (l == 0) l = (lag < 0)?-1:1;							// Zero means unknown
+	TIP_CFG::lag = l;
+	if (!tip_table || gun_mode) return false;
+	uint8_t tip_chunk_index = tip_table[a_cfg.tip].tip_chunk_index;
+	if (tip_chunk_index == NO_TIP_CHUNK) return false;
+	TIP tip;
+	if (loadTipData(&tip, tip_chunk_index) != EPR_OK) return false;
+	if (l == tip.lag) return true;
+	tip.lag = l;
+	return (saveTipData(&tip, tip_chunk_index) == EPR_OK);
+}
+
+/*
+ * Save the holding power model of the current tip, see TIP_HOLD_MAX. The EEPROM is written only if the model has changed.
+ * If the tip is not in the EEPROM, the model is kept till the tip is changed
+ */
+bool CFG::saveTipHold(uint8_t hold) {
+	if (hold > TIP_HOLD_MAX) hold = TIP_HOLD_MAX;
+	TIP_CFG::hold = hold;
+	if (!tip_table || gun_mode) return false;
+	uint8_t tip_chunk_index = tip_table[a_cfg.tip].tip_chunk_index;
+	if (tip_chunk_index == NO_TIP_CHUNK) return false;
+	TIP tip;
+	if (loadTipData(&tip, tip_chunk_index) != EPR_OK) return false;
+	if (hold == tip.hold) return true;
+	tip.hold = hold;
+	return (saveTipData(&tip, tip_chunk_index) == EPR_OK);
+}
+
+/*
+ * Save new IRON tip calibration data to the EEPROM only. Do not change active configuration
+ * The holding power model is cleared, the PID parameters and the thermal lag of the tip are kept
+ */
 void CFG::saveTipCalibtarion(uint8_t index, uint16_t temp[4], uint8_t mask, int8_t ambient) {
 	TIP tip;
+	memset(&tip, 0, sizeof(TIP));
+	if (tip_table[index].tip_chunk_index != NO_TIP_CHUNK) {
+		TIP old_tip;
+		if (loadTipData(&old_tip, tip_table[index].tip_chunk_index) == EPR_OK) {
+			tip.lag				= old_tip.lag;				// The time does not depend on the temperature scale
+			if (old_tip.mask & TIP_PID) {
+				mask			|= old_tip.mask & (TIP_PID | TIP_SMITH);
+				tip.model_gain	= old_tip.model_gain;
+				tip.model_tau	= old_tip.model_tau;
+				tip.model_dead	= old_tip.model_dead;
+				tip.pid_weight	= old_tip.pid_weight;
+				tip.pid_Kp		= old_tip.pid_Kp;
+				tip.pid_Ki		= old_tip.pid_Ki;
+				tip.pid_Kd		= old_tip.pid_Kd;
+			}
+		}
+	}
 	tip.t200		= temp[0];
 	tip.t260		= temp[1];
 	tip.t330		= temp[2];
@@ -224,6 +348,7 @@ bool CFG::toggleTipActivation(uint8_t index) {
 		if (tip_chunk_index == NO_TIP_CHUNK) return false;	// Failed to find free slot to save tip configuration
 		const char *name = TIPS::name(index);
 		if (name) {
+			memset(&tip, 0, sizeof(TIP));
 			strncpy(tip.name, name, tip_name_sz);			// Initialize tip name
 			tip.mask = TIP_ACTIVE;
 			if (saveTipData(&tip, tip_chunk_index) == EPR_OK) {
@@ -315,8 +440,8 @@ void CFG::clearAllTipsCalibration(void) {
 			// Check The tip is calibrated
 			if ((m & TIP_ACTIVE) && (m & TIP_CALIBRATED)) {
 				if (loadTipData(&tmp_tip, i) == EPR_OK) {
-					tmp_tip.mask 			= TIP_ACTIVE;	// Clear calibrated flag
-					tip_table[i].tip_mask	= TIP_ACTIVE;
+					tmp_tip.mask 			= m & ~TIP_CALIBRATED;	// Clear calibrated flag
+					tip_table[i].tip_mask	= tmp_tip.mask;
 					if (saveTipData(&tmp_tip, i) != EPR_OK) {
 						break;								// Stop writing to EEPROM on the first IO error
 					}
@@ -387,6 +512,7 @@ bool CFG_CORE::areConfigsIdentical(void) {
 	if (a_cfg.bit_mask			!= s_cfg.bit_mask)			return false;
 	if (a_cfg.boost				!= s_cfg.boost)				return false;
 	if (a_cfg.scr_save_timeout	!= s_cfg.scr_save_timeout)	return false;
+	if (a_cfg.settle			!= s_cfg.settle)			return false;
 	return true;
 };
 
@@ -427,9 +553,11 @@ void CFG_CORE::setDefaults(void) {
 	a_cfg.bit_mask			= CFG_CELSIUS | CFG_BUZZER;
 	a_cfg.boost				= 0;
 	a_cfg.scr_save_timeout	= 0;
+	a_cfg.settle			= 0;
 	a_cfg.pid_Kp			= 2300;
 	a_cfg.pid_Ki			= 48;
 	a_cfg.pid_Kd			= 1700;
+	a_cfg.pid_weight		= packWeights(PIDparam());
 }
 
 void CFG_CORE::correctConfig(RECORD *cfg) {
@@ -445,10 +573,13 @@ void CFG_CORE::correctConfig(RECORD *cfg) {
 	if (cfg->off_timeout > 30)		cfg->off_timeout 		= 30;
 	if (cfg->tip > TIPS::loaded())	cfg->tip 				= 1;
 	if (cfg->scr_save_timeout > 60) cfg->scr_save_timeout 	= 60;
+	if (cfg->settle > 60)			cfg->settle				= 0;	// Not measured, see adcBlanking()
+	if ((cfg->pid_weight >> 4) > PIDparam::weight_one + 1 || (cfg->pid_weight & 0xF) > PIDparam::weight_one + 1)
+		cfg->pid_weight = 0;								// The default weights
 }
 
 // Apply main configuration parameters: automatic off timeout, buzzer and temperature units
-void CFG_CORE::setup(uint8_t off_timeout, bool buzzer, bool celsius, bool reed, uint16_t low_temp, uint8_t low_to, uint8_t scr_saver) {
+void CFG_CORE::setup(uint8_t off_timeout, bool buzzer, bool celsius, bool reed, uint16_t low_temp, uint8_t low_to, uint8_t scr_saver, bool adapt) {
 	bool cfg_celsius		= a_cfg.bit_mask & CFG_CELSIUS;
 	a_cfg.off_timeout		= off_timeout;
 	a_cfg.scr_save_timeout	= scr_saver;
@@ -466,6 +597,7 @@ void CFG_CORE::setup(uint8_t off_timeout, bool buzzer, bool celsius, bool reed,
 	if (celsius)	a_cfg.bit_mask |= CFG_CELSIUS;
 	if (buzzer)		a_cfg.bit_mask |= CFG_BUZZER;
 	if (reed)		a_cfg.bit_mask |= CFG_SWITCH;
+	if (adapt)		a_cfg.bit_mask |= CFG_ADAPT;
 }
 
 uint8_t CFG_CORE::currentTipIndex(void) {
@@ -521,9 +653,26 @@ void CFG_CORE::saveBoost(uint8_t temp, uint8_t duration) {
 	a_cfg.boost |= ((duration-1)/5) & 0xF;
 }
 
-// PID parameters: Kp, Ki, Kd
+// PID parameters: Kp, Ki, Kd and the setpoint weights b, c
 PIDparam CFG_CORE::pidParams(void) {
-	return PIDparam(a_cfg.pid_Kp, a_cfg.pid_Ki, a_cfg.pid_Kd);
+	return unpackPID(a_cfg.pid_Kp, a_cfg.pid_Ki, a_cfg.pid_Kd, a_cfg.pid_weight);
+}
+
+/*
+ * The setpoint weights are saved plus one, so the zero field is told apart from the zero weight: the records saved
+ * before the weights were introduced have zero there. These records are loaded with the default weights b = 1.0, c = 0
+ */
+uint8_t CFG_CORE::packWeights(const PIDparam& pp) {
+	uint8_t b = constrain(pp.b, 0, PIDparam::weight_one) + 1;
+	uint8_t c = constrain(pp.c, 0, PIDparam::weight_one) + 1;
+	return (b << 4) | c;
+}
+
+PIDparam CFG_CORE::unpackPID(int32_t Kp, int32_t Ki, int32_t Kd, uint8_t weight) {
+	PIDparam pp(Kp, Ki, Kd);								// The default weights
+	if (weight >> 4)	pp.b = (weight >> 4) - 1;
+	if (weight & 0xF)	pp.c = (weight & 0xF) - 1;
+	return pp;
 }
 
 // PID parameters: Kp, Ki, Kd for smooth work, i.e. tip calibration
@@ -590,6 +739,24 @@ uint16_t TIP_CFG::tempCelsius(uint16_t temp, int16_t ambient) {
 	return tempH;
 }
 
+/*
+ * The holding power is proportional to the tip temperature over ambient: the heat is lost by the tip surface and the handle.
+ * The model is the power per Celsius over ambient in 1/16 units, see TIP_HOLD_MAX
+ */
+uint16_t TIP_CFG::holdPower(uint16_t temp, int16_t ambient) {
+	int16_t over = tempCelsius(temp, ambient) - ambient;
+	if (hold == 0 || over <= 0) return 0;
+	return ((uint32_t)hold * over + 8) >> 4;
+}
+
+// Build the holding power model by the power applied to keep the temperature (internal units), 0 if the temperature is too low
+uint8_t TIP_CFG::holdModel(uint16_t temp, int16_t ambient, uint16_t power) {
+	int16_t over = tempCelsius(temp, ambient) - ambient;
+	if (over < (int16_t)hold_min_over) return 0;
+	uint32_t h = ((uint32_t)power * 16 + over/2) / over;
+	return constrain(h, 1, TIP_HOLD_MAX);
+}
+
 // Return the reference temperature points of the IRON tip calibration
 void TIP_CFG::getTipCalibtarion(uint16_t temp[4]) {
 	for (uint8_t j = 0; j < 4; ++j)
@@ -12,23 +12,107 @@
 #include "oled.h"
 #include "tools.h"
 #include "buzzer.h"
+#include "ring.h"
 
-#define ADC_CONV 	(2)										// Activated ADC Ranks Number (hadc2.Init.NbrOfConversion)
-#define ADC_LOOPS	(2)										// Number of ADC conversion loops. Should be even
-#define ADC_BUFF_SZ	(2*ADC_CONV*ADC_LOOPS)
+#ifndef ADC_TEMP_OS_P
+#define ADC_TEMP_OS_P	(6)									// Oversampling depth: 2^ADC_TEMP_OS_P samples of iron_temp per TIM2 period, 4...8
+#endif
+#if ADC_TEMP_OS_P < 4 || ADC_TEMP_OS_P > 8
+#error "ADC_TEMP_OS_P should be in 4...8 range"
+#endif
+#define ADC_TEMP_OS		(1 << ADC_TEMP_OS_P)				// iron_temp samples per TIM2 period (16...256)
+#define ADC_TEMP_FRAC	(ADC_TEMP_OS_P/2)					// Extra bits of iron_temp: oversampling by 4 gives one effective bit
+#define ADC_RANKS		(16)								// hadc1.Init.NbrOfConversion, both ADCs sample iron_temp and ambient in turn
+#define ADC_AMB_PERIOD	(16)								// TIM2 periods between ambient measurements, the heater current is sampled instead
+#define ADC_SEQ			(ADC_TEMP_OS/ADC_RANKS)				// Regular sequences per TIM2 period
+#define ADC_SEQ_TICKS	(6)									// TIM2 ticks between sequence triggers, one sequence takes 16 * 41 ADC clocks = 54.7 us
+#define ADC_HALF_SZ		(2*ADC_RANKS*ADC_SEQ)				// The data of one TIM2 period, both ADCs
+#define ADC_BUFF_SZ		(2*ADC_HALF_SZ)						// Circular DMA double buffer
+#define ADC_WINDOW(p)	((p) - ADC_SEQ*ADC_SEQ_TICKS)		// TIM2 CC2 value of the first sequence: the start of measurement window of the period p
+#define ADC_NO_TRIGGER	(0xFFFF)							// TIM2 CC2 value out of the period: no measurement window in this period
+#define ADC_PWM_REF		(2000)								// The TIM2 period (ticks) the IRON power is calculated for, see IRON::max_power
+#define ADC_PWM_DITHER	(8)									// Fractional bits of the IRON power kept by the sigma-delta modulator, see adcDither()
+#ifndef ADC_TEMP_FILTER
+#define ADC_TEMP_FILTER	(ADC_FILTER_MEDIAN)					// The default front-end of iron_temp samples, see adcTempSum()
+#endif
+#define ADC_REJECT		(24)								// The sample deviating from the robust estimate by more than this is rejected (ADC counts)
+#define ADC_TC_OPEN		(4000)								// The thermocouple amplifier is saturated in the measurement window: no tip (ADC counts)
+#define ADC_SAMPLES		(64)								// The raw sample ring size, 1.3 seconds at 48 Hz
+#define ADC_FAST_BAND	(80)								// Run the fast control rate when the temperature is out of this band (internal units)
+#define ADC_FAST_HOLD	(96)								// Measurements to keep the fast rate after the temperature returns to the band
+#define ADC_BLANK		(20)								// Default blanking window: TIM2 ticks between IRON power off and the measurement window
+#define ADC_BLANK_MIN	(1)									// The blanking window limits, see adcBlanking()
+#define ADC_BLANK_MAX	(60)
+#define ADC_SETTLE_PWM	(400)								// The IRON power while the amplifier settle time is measured
+#define ADC_SETTLE_LOOPS (4)								// TIM2 periods to average the settle curve point
+#define ADC_SETTLE_TOL	(2)									// The settled sequence deviates from the reference by less than this (ADC counts)
+#define ADC_SETTLE_MARGIN (2)								// Extra TIM2 ticks added to the measured settle time
 
 extern ADC_HandleTypeDef	hadc1;
 extern ADC_HandleTypeDef	hadc2;
 extern TIM_HandleTypeDef	htim2;
 
-typedef enum { ADC_IDLE, ADC_CURRENT, ADC_TEMP } t_ADC_mode;
-volatile static t_ADC_mode	adc_mode = ADC_IDLE;
 volatile static uint16_t	buff[ADC_BUFF_SZ];
-volatile static uint8_t		check_count	= 1;				// Decrement from check_period to zero by TIM2. When become zero, force to check the IRON connectivity
+static uint16_t				adc_trig[ADC_SEQ];				// TIM2 CCR2 values loaded by DMA on each CC2 event: the next sequence trigger
+volatile static uint16_t* volatile adc_half	= 0;			// The buffer half ready to be processed by the bottom half (PendSV_Handler)
+volatile static uint32_t	adc_ready		= 0;			// Buffer halves completed by DMA, incremented by the ISR only
+volatile static uint32_t	adc_done		= 0;			// Buffer halves processed, updated by the bottom half only
+volatile static uint32_t	adc_stamp		= 0;			// DWT cycle counter at the last DMA complete interrupt
+static ADC_TIMING			adc_timing;						// The timing statistics of the ADC data processing
+static uint32_t				sqr_amb[2][3];					// ADC1, ADC2 regular sequence registers SQR1-SQR3: iron_temp and ambient
+static uint32_t				sqr_idle[2][3];					// The same sequence with the heater current channel instead of ambient
+static uint8_t				amb_count		= 0;			// TIM2 periods till the next ambient measurement
+static uint8_t				amb_warmup		= 0;			// TIM2 periods to sample ambient every time after power on, see adcScheduleInit()
+static bool					amb_window		= true;			// The sequence registers are loaded with ambient channel (sqr_amb)
 
-const static uint16_t  		max_iron_pwm	= 1960;			// Max value should be less than TIM2.CHANNEL3 value by 20
-const static uint16_t		check_iron_pwm	= 5;			// This power should be applied to check the current through the IRON
-const static uint8_t		check_period	= 6;			// TIM2 loops between check current through the iron
+/*
+ * The control and measurement rates: the TIM2 period (the IRON PWM carrier) and the measurement window every Nth period.
+ * The IRON power is calculated by the PID for ADC_PWM_REF period and scaled to the active rate.
+ * Only the last period of the measurement cycle has the measurement window, the other ones can power the IRON all the time
+ */
+typedef struct s_adc_rate ADC_RATE_CFG;
+struct s_adc_rate {
+	uint16_t	period;										// TIM2 period, ticks (96 kHz)
+	uint8_t		every;										// Measure the temperature every Nth period
+};
+static const ADC_RATE_CFG	adc_rates[ADC_RATE_AUTO] = {
+	{ 2000, 4 },											// ADC_RATE_SLOW:		48 Hz PWM, 12 Hz control, the IRON is off
+	{ 2000, 1 },											// ADC_RATE_NORMAL:		48 Hz PWM and control
+	{ 1000, 1 },											// ADC_RATE_FAST:		96 Hz PWM and control, heating up and the load disturbance
+	{ 1000, 2 },											// ADC_RATE_CARRIER:	96 Hz PWM, 48 Hz control
+};
+static ADC_RATE				adc_rate		= ADC_RATE_NORMAL;	// The active rate
+static ADC_RATE				rate_fixed		= ADC_RATE_AUTO;	// The rate required by adcRate()
+static uint16_t				adc_period		= ADC_PWM_REF;	// TIM2 period of the active rate, ticks
+static uint8_t				adc_every		= 1;			// Measurement window every Nth period
+static uint16_t				adc_window		= ADC_WINDOW(ADC_PWM_REF);	// The first sequence trigger of the active rate
+volatile static uint32_t	adc_interval	= 0;			// CPU cycles between two measurements
+volatile static uint8_t		pwm_count		= 0;			// The TIM2 period index in the measurement cycle, updated by the injected group ISR
+volatile static uint16_t	pwm_meas		= 0;			// CCR1 value of the period with the measurement window
+volatile static uint16_t	pwm_other		= 0;			// CCR1 value of the other periods of the measurement cycle
+static uint8_t				fast_hold		= 0;			// Measurements to keep the fast rate
+static uint8_t				adc_blank		= ADC_BLANK;	// The blanking window, see adcBlanking()
+static uint32_t				pwm_dither		= 0;			// The power fraction not applied yet, 1/2^ADC_PWM_DITHER of TIM2 tick
+static RING<ADC_SAMPLE, ADC_SAMPLES>	samples;			// The raw data from the bottom half to the main loop
+static ADC_FILTER			temp_filter		= ADC_TEMP_FILTER;	// The front-end of iron_temp samples
+volatile static uint32_t	temp_rejected	= 0;			// The number of rejected iron_temp samples
+volatile static uint16_t	raw_current		= 0;			// The last IRON current reading, see HAL_ADCEx_InjectedConvCpltCallback()
+static uint16_t				raw_ambient		= 0;			// The last ambient reading
+
+static void adcScheduleInit(void);
+static void adcTriggers(void);
+static void adcSettle(volatile uint16_t* data);
+
+static uint16_t				max_iron_pwm	= ADC_WINDOW(ADC_PWM_REF) - ADC_BLANK;	// Max value should be less than the measurement window start by the blanking window
+static uint8_t				settle_delay	= 0;			// The first sequence starts after IRON power off by this (TIM2 ticks), 0 if not measuring
+static uint8_t				settle_loop		= 0;			// TIM2 periods measured at the current delay
+static uint8_t				settle_skip		= 0;			// TIM2 periods to skip before the settle power is applied
+static uint8_t				settle_result	= 0;			// The measured blanking window (TIM2 ticks), 0 if failed
+volatile static bool		settle_done		= true;			// The settle time measurement is complete
+static int32_t				settle_dev[ADC_BLANK_MAX+1];	// The deviation of the first sequence from the reference, (ADC counts)*16*ADC_SETTLE_LOOPS
+const static uint16_t		curr_min_pwm	= 5;			// The IRON should be powered this long (ticks) to read the current at the period start
+const static uint8_t		check_period	= 6;			// Measurements between the current probes while the current is lost
+static uint8_t				check_count		= check_period;	// Measurements till the next current probe, see adcProcess()
 
 static HW		core;										// Hardware core (including all device instances)
 
@@ -40,7 +124,8 @@ static	MSLCT			select(&core);
 static	MTACT			activate(&core);
 static	MCALIB			calib_auto(&core);
 static	MCALIB_MANUAL	calib_manual(&core);
-static	MCALMENU		calib_menu(&core, &calib_auto, &calib_manual);
+static	MSETTLE			calib_settle(&core);
+static	MCALMENU		calib_menu(&core, &calib_auto, &calib_manual, &calib_settle);
 static	MTUNE			tune(&core);
 static	MFAIL			fail(&core);
 static	MMBST			boost_setup(&core);
@@ -59,6 +144,11 @@ CFG_STATUS HW::init(void) {
 	CFG_STATUS cfg_init = 	cfg.init();
 	PIDparam pp   		= 	cfg.pidParams();				// load IRON PID parameters
 	iron.load(pp);
+	iron.model(cfg.pidModel(), cfg.isTipSmith());
+	iron.trackInit(cfg.tipModel());
+	PID_SCHEDULE ps;
+	if (cfg.loadSchedule(&ps))								// load the PID gain schedule if the bands were tuned
+		iron.schedule(&ps);
 	buzz.activate(cfg.isBuzzerEnabled());
 	return cfg_init;
 }
@@ -66,11 +156,23 @@ CFG_STATUS HW::init(void) {
 extern "C" void setup(void) {
 	CFG_STATUS cfg_init = core.init();						// Initialize the hardware structure before start timers
 
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;			// Enable the DWT cycle counter to measure the interrupt handlers duration
+	DWT->CYCCNT	 = 0;
+	DWT->CTRL	|= DWT_CTRL_CYCCNTENA_Msk;
+
 	HAL_ADCEx_Calibration_Start(&hadc1);					// Calibrate both ADCs
 	HAL_ADCEx_Calibration_Start(&hadc2);
+	adcScheduleInit();
+	adcBlanking(core.cfg.settleTicks());					// Use the measured amplifier settle time if any
+	HAL_ADCEx_InjectedStart(&hadc2);						// The injected group is triggered by TIM2 TRGO (OC3REF) to check the current through the IRON
+	HAL_ADCEx_InjectedStart_IT(&hadc1);
+	HAL_ADC_Start(&hadc2);									// The regular group is triggered by TIM2 CC2 event to read the temperatures
+	HAL_ADCEx_MultiModeStart_DMA(&hadc1, (uint32_t*)buff, ADC_BUFF_SZ/2);	// Free-running circular DMA, see HAL_ADC_MspInit()
+	adcTriggers();
+	TIM2->CCR2	= adc_window;
+	adc_interval = (TIM2->PSC + 1) * adc_period;
 	HAL_TIM_PWM_Start(&htim2, 	TIM_CHANNEL_1);				// PWM signal of the IRON
-	HAL_TIM_OC_Start_IT(&htim2,	TIM_CHANNEL_3);				// Check the current through the IRON
-	HAL_TIM_OC_Start_IT(&htim2, TIM_CHANNEL_4);				// Calculate power of the IRON
+	HAL_TIM_OC_Start_DMA(&htim2, TIM_CHANNEL_2, (uint32_t*)adc_trig, ADC_SEQ);	// The compare events trigger the ADC sequences, see HAL_TIM_Base_MspInit()
 
 	// Setup mode parameters: return mode, short press mode, long press mode
 	standby_iron.setup(&select, &work_iron, &main_menu);
@@ -80,6 +182,7 @@ extern "C" void setup(void) {
 	activate.setup(&standby_iron, &standby_iron, &main_menu);
 	calib_auto.setup(&standby_iron, &standby_iron, &standby_iron);
 	calib_manual.setup(&calib_menu, &standby_iron, &standby_iron);
+	calib_settle.setup(&calib_menu, &standby_iron, &standby_iron);
 	calib_menu.setup(&standby_iron, &standby_iron, &standby_iron);
 	tune.setup(&standby_iron, &standby_iron, &standby_iron);
 	fail.setup(&standby_iron, &standby_iron, &standby_iron);
@@ -90,6 +193,7 @@ extern "C" void setup(void) {
 	about.setup(&standby_iron, &standby_iron, &debug);
     debug.setup(&standby_iron, &standby_iron, &standby_iron);
 
+	pMode	= &standby_iron;								// The controller starts in the standby mode
 	switch (cfg_init) {
 		case	CFG_NO_TIP:
 			pMode	= &activate;							// No tip configured, run tip activation menu
@@ -130,82 +234,491 @@ extern "C" void loop(void) {
 	}
 }
 
-static bool adcStart(t_ADC_mode mode) {
-    if (adc_mode != ADC_IDLE) {								// Not ready to check analog data; Something is wrong!!!
-    	TIM2->CCR1 = 0;										// Switch off the IRON
-		return false;
-    }
-	HAL_ADC_Start(&hadc2);
-    HAL_ADCEx_MultiModeStart_DMA(&hadc1, (uint32_t*)buff, ADC_CONV*ADC_LOOPS);
-	adc_mode = mode;
-	return true;
+// Update the statistics by new measurement, the average is exponential with factor 1/16
+static void cycleStat(CYCLE_STAT* s, uint32_t cycles) {
+	if (s->count == 0) {
+		s->min = s->avg = s->max = cycles;
+	} else {
+		if (cycles < s->min) s->min = cycles;
+		if (cycles > s->max) s->max = cycles;
+		s->avg = (int32_t)s->avg + ((int32_t)cycles - (int32_t)s->avg) / 16;
+	}
+	++s->count;
+}
+
+// Replace the channel in the 5-bit fields of the regular sequence register
+static uint32_t sqrReplace(uint32_t sqr, uint8_t fields, uint32_t from, uint32_t to) {
+	for (uint8_t f = 0; f < fields; ++f) {
+		uint8_t shift = 5*f;
+		if (((sqr >> shift) & 0x1F) == from)
+			sqr = (sqr & ~(0x1FU << shift)) | (to << shift);
+	}
+	return sqr;
 }
 
 /*
- * IRQ handler
- * on TIM2 Output channel #3 to read the current through the IRON and Fan of Hot Air Gun
- * also check that TIM1 counter changed driven by AC_ZERO interrupt
- * on TIM2 Output channel #4 to read the IRON, HOt Air Gun and ambient temperatures
+ * The ambient temperature changes slowly, so the ambient channel is sampled once in ADC_AMB_PERIOD TIM2 periods.
+ * In the other periods the ambient slots sample the heater current channel: the IRON is not powered
+ * in the measurement window, so it is the zero offset of the current amplifier.
+ * The iron_temp slots are not changed: the same channel cannot be sampled by both ADCs at the same time,
+ * so every conversion slot has iron_temp sample on one ADC only
  */
-extern "C" void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim) {
-	if (htim->Instance == TIM2) {
-		if (htim->Channel == HAL_TIM_ACTIVE_CHANNEL_3) {
-			if (TIM2->CCR1)									// If IRON has been powered
-				adcStart(ADC_CURRENT);
-		} else if (htim->Channel == HAL_TIM_ACTIVE_CHANNEL_4) {
-			adcStart(ADC_TEMP);
+static void adcScheduleInit(void) {
+	ADC_TypeDef* adc[2] = { hadc1.Instance, hadc2.Instance };
+	for (uint8_t i = 0; i < 2; ++i) {
+		sqr_amb[i][0]	= adc[i]->SQR1;
+		sqr_amb[i][1]	= adc[i]->SQR2;
+		sqr_amb[i][2]	= adc[i]->SQR3;
+		sqr_idle[i][0]	= sqrReplace(sqr_amb[i][0], 4, ADC_CHANNEL_6, ADC_CHANNEL_2);	// SQR1: ranks 13-16 and the sequence length
+		sqr_idle[i][1]	= sqrReplace(sqr_amb[i][1], 6, ADC_CHANNEL_6, ADC_CHANNEL_2);
+		sqr_idle[i][2]	= sqrReplace(sqr_amb[i][2], 6, ADC_CHANNEL_6, ADC_CHANNEL_2);
+	}
+	amb_count	= ADC_AMB_PERIOD;
+	amb_warmup	= 64;										// Let the ambient exponential average settle quickly
+	amb_window	= true;
+	pwm_dither	= 0;
+	fast_hold	= 0;
+	check_count	= check_period;
+}
+
+// Load the sequence of the next measurement window. It is called from the bottom half before the next window starts
+static void adcSchedule(bool ambient) {
+	if (ambient == amb_window) return;
+	ADC_TypeDef* adc[2] = { hadc1.Instance, hadc2.Instance };
+	for (uint8_t i = 0; i < 2; ++i) {
+		uint32_t* sqr = ambient?sqr_amb[i]:sqr_idle[i];
+		adc[i]->SQR1 = sqr[0];
+		adc[i]->SQR2 = sqr[1];
+		adc[i]->SQR3 = sqr[2];
+	}
+	amb_window = ambient;
+}
+
+// Build the sequence triggers of the measurement window: each CC2 event loads the trigger time of the next sequence
+static void adcTriggers(void) {
+	for (uint8_t i = 0; i < ADC_SEQ; ++i)
+		adc_trig[i] = adc_window + ((i+1) % ADC_SEQ) * ADC_SEQ_TICKS;
+}
+
+/*
+ * Select the control rate: slow when the IRON is off, fast when the temperature is far from the preset one
+ * (heating up or the load applied) and some time after it returns back. The fast rate has shorter maximum duty,
+ * so the full power is applied on the normal rate. The settle time is measured on the normal rate
+ */
+static ADC_RATE adcRatePolicy(bool connected, uint16_t power) {
+	if (settle_delay) return ADC_RATE_NORMAL;
+	if (rate_fixed != ADC_RATE_AUTO) return rate_fixed;
+	if (!connected || core.iron.isCold()) {
+		fast_hold = 0;
+		return ADC_RATE_SLOW;
+	}
+	if (!core.iron.isOn()) {
+		fast_hold = 0;
+		return ADC_RATE_NORMAL;
+	}
+	int16_t diff = (int16_t)core.iron.presetTemp() - (int16_t)core.iron.temp();
+	if (diff > ADC_FAST_BAND || diff < -ADC_FAST_BAND) {
+		fast_hold = ADC_FAST_HOLD;
+		uint16_t fast_period = adc_rates[ADC_RATE_FAST].period;
+		if ((uint32_t)power * fast_period / ADC_PWM_REF >= (uint32_t)(ADC_WINDOW(fast_period) - adc_blank))
+			return ADC_RATE_NORMAL;
+		return ADC_RATE_FAST;
+	}
+	if (fast_hold) {
+		--fast_hold;
+		return ADC_RATE_FAST;
+	}
+	return ADC_RATE_NORMAL;
+}
+
+// Tell the PID the maximum power of the active rate (ADC_PWM_REF domain): the periods without measurement window are not limited
+static void adcPowerLimit(void) {
+	uint32_t cycle	= (uint32_t)adc_period * adc_every;
+	uint32_t max	= max_iron_pwm + (uint32_t)(adc_every - 1) * adc_period;
+	core.iron.powerLimit(max * ADC_PWM_REF / cycle);
+}
+
+/*
+ * Switch the control rate. It is called by the bottom half after the last sequence of the measurement window,
+ * before the TIM2 update event, so the new period (ARR is preloaded) and CCR1 value are applied on the next TIM2 period.
+ * If the bottom half is late, the new period has started already, try on the next measurement
+ */
+static void adcRateApply(ADC_RATE rate) {
+	if (rate == adc_rate || rate >= ADC_RATE_AUTO) return;
+	if (TIM2->CNT < adc_window) return;
+	adc_rate		= rate;
+	adc_period		= adc_rates[rate].period;
+	adc_every		= adc_rates[rate].every;
+	adc_window		= ADC_WINDOW(adc_period);
+	max_iron_pwm	= adc_window - adc_blank;
+	adcTriggers();
+	pwm_count		= adc_every - 1;						// The current period is the last one of the measurement cycle
+	TIM2->ARR		= adc_period - 1;
+	TIM2->CCR2		= (adc_every > 1)?ADC_NO_TRIGGER:adc_window;
+	adc_interval	= (TIM2->PSC + 1) * adc_period * adc_every;
+	core.iron.controlPeriod((uint32_t)adc_period * adc_every * PID::ref_period / ADC_PWM_REF);
+	adcPowerLimit();
+}
+
+/*
+ * First order sigma-delta modulator of the IRON power. The PID output keeps ADC_PWM_DITHER fractional bits,
+ * but CCR1 is integer: the fraction is carried to the next measurement cycle, so the average power
+ * has the resolution of the PID output. The accumulator is less than one tick, so it cannot wind up.
+ * The fine power is less than 2^19, so the product by the measurement cycle (8000 ticks max) fits 32 bits
+ */
+static uint32_t adcDither(uint32_t fine_power) {
+	uint32_t pwm = fine_power * adc_period * adc_every / ADC_PWM_REF + pwm_dither;
+	pwm_dither	= pwm & ((1 << ADC_PWM_DITHER) - 1);
+	return pwm >> ADC_PWM_DITHER;
+}
+
+// Move the first sequence trigger of the next TIM2 period. The trigger table entry is loaded to CCR2 on the last sequence trigger
+static void adcFirstTrigger(uint16_t tick) {
+	adc_trig[ADC_SEQ-1]	= tick;
+	TIM2->CCR2			= tick;								// The bottom half runs after the last trigger, so the value is loaded already
+}
+
+/*
+ * The amplifier settle time measurement. The IRON is powered by ADC_SETTLE_PWM, the first sequence of the window
+ * is triggered settle_delay ticks after the power off, the other sequences are taken in the normal window and used as a reference.
+ * Every delay from ADC_BLANK_MIN to ADC_BLANK_MAX is averaged over ADC_SETTLE_LOOPS periods.
+ * The CCR1 value is applied on the next update event, so the first periods are skipped
+ */
+static void adcSettle(volatile uint16_t* data) {
+	TIM2->CCR1 = ADC_SETTLE_PWM;
+	if (settle_skip) {
+		--settle_skip;
+	} else {
+		int32_t first	= 0;
+		int32_t ref		= 0;
+		for (uint16_t i = 0; i < ADC_HALF_SZ; i += 4) {
+			if (i < 2*ADC_RANKS)
+				first	+= data[i+1] + data[i+2];
+			else
+				ref		+= data[i+1] + data[i+2];
+		}
+		settle_dev[settle_delay] += first - ref / ((ADC_SEQ > 1)?(ADC_SEQ-1):1);	// Both sums are of 16 samples. See adcSettleStart()
+		if (++settle_loop >= ADC_SETTLE_LOOPS) {
+			settle_loop = 0;
+			if (++settle_delay > ADC_BLANK_MAX) {			// All the delays are measured, find the first one when the amplifier is settled
+				settle_result = 0;
+				for (int8_t d = ADC_BLANK_MAX; d >= ADC_BLANK_MIN; --d) {
+					int32_t dev = settle_dev[d];
+					if (dev < 0) dev = -dev;
+					if (dev > ADC_SETTLE_TOL*16*ADC_SETTLE_LOOPS) break;
+					settle_result = d;
+				}
+				if (settle_result) {
+					settle_result += ADC_SETTLE_MARGIN;
+					if (settle_result > ADC_BLANK_MAX) settle_result = 0;
+				}
+				adcSettleStop();
+				return;
+			}
+		}
+	}
+	adcFirstTrigger(ADC_SETTLE_PWM + settle_delay);
+}
+
+static inline uint32_t min2(uint32_t a, uint32_t b)	{ return (a < b)?a:b; }
+static inline uint32_t max2(uint32_t a, uint32_t b)	{ return (a > b)?a:b; }
+
+// The median of three values without branches: the conditional selects are compiled to IT blocks
+static inline uint32_t med3(uint32_t a, uint32_t b, uint32_t c) {
+	return max2(min2(a, b), min2(max2(a, b), c));
+}
+
+// The iron_temp sample k in the conversion order: ADC2 rank 2n+1 and ADC1 rank 2n+2 in each group of four buffer words
+static inline uint32_t tempSample(volatile uint16_t* data, uint16_t k) {
+	return data[4*(k >> 1) + 1 + (k & 1)];
+}
+
+// 1 if the sample deviates from the estimate by more than ADC_REJECT
+static inline uint32_t rejected(uint32_t sample, uint32_t estimate) {
+	return (uint32_t)((int32_t)sample - (int32_t)estimate + ADC_REJECT) > 2*ADC_REJECT;
+}
+
+/*
+ * The robust front-end of iron_temp samples. Returns the sum of ADC_TEMP_OS values, so the decimation does not change.
+ * ADC_FILTER_MEAN:		plain sum, the boxcar filter
+ * ADC_FILTER_MEDIAN:	sliding median of three, a single corrupted conversion is replaced by its neighbor
+ * ADC_FILTER_TRIMMED:	the blocks of four samples, the minimum and the maximum of the block are dropped,
+ * 						the middle pair is counted twice
+ * The samples that differ from the median (the middle pair average) by more than ADC_REJECT are counted in temp_rejected
+ */
+static uint32_t adcTempSum(volatile uint16_t* data) {
+	uint32_t sum = 0;
+	uint32_t rej = 0;
+	switch (temp_filter) {
+		case ADC_FILTER_MEDIAN:
+		{
+			uint32_t prev	= tempSample(data, 1);			// The sequence is reflected at both ends
+			uint32_t cur	= tempSample(data, 0);
+			uint32_t m		= 0;
+			for (uint16_t k = 1; k < ADC_TEMP_OS; ++k) {
+				uint32_t next = tempSample(data, k);
+				m	 = med3(prev, cur, next);
+				sum	+= m;
+				rej	+= rejected(cur, m);
+				prev = cur;
+				cur	 = next;
+			}
+			m	 = med3(prev, cur, prev);
+			sum	+= m;
+			rej	+= rejected(cur, m);
+			break;
 		}
+		case ADC_FILTER_TRIMMED:
+			for (uint16_t i = 0; i < ADC_HALF_SZ; i += 8) {
+				uint32_t a	= data[i+1];
+				uint32_t b	= data[i+2];
+				uint32_t c	= data[i+5];
+				uint32_t d	= data[i+6];
+				uint32_t lo	= min2(min2(a, b), min2(c, d));
+				uint32_t hi	= max2(max2(a, b), max2(c, d));
+				uint32_t s	= a + b + c + d - lo - hi;
+				sum += 2*s;
+				rej += rejected(lo, s/2) + rejected(hi, s/2);
+			}
+			break;
+		default:
+			for (uint16_t i = 0; i < ADC_HALF_SZ; i += 4)
+				sum += data[i+1] + data[i+2];
+			break;
 	}
+	temp_rejected += rej;
+	return sum;
 }
 
 /*
- * IRQ handler of ADC complete request. The data is in the ADC buffer (buff)
- * Data read by 4 slots interleaved: adc1-rank1, adc2-rank1, adc1-rank2, adc2-rank2
- * The ADC buffer would have the following fields (see MX_ADC1_Init() MX_ADC2_Init() in main.c)
+ * Process the data of one TIM2 period, the half of the ADC buffer (buff) that is not being written by DMA
+ * Data read by 4 slots simultaneous: adc1-rank1, adc2-rank1, adc1-rank2, adc2-rank2...
+ * The ADC buffer half would have the following fields (see MX_ADC1_Init() MX_ADC2_Init() in main.c)
  * ADC1:			ADC2:
- * iron_current		iron_temp
  * ambient			iron_temp
+ * iron_temp		ambient
+ * ...				...
+ * The same channel is never sampled by both ADCs at the same time.
+ * The ADC_SEQ sequences of 16 ranks make ADC_TEMP_OS samples of each channel.
+ * The iron_temp samples pass the robust front-end (adcTempSum()), then decimation is a boxcar filter:
+ * the sum of the samples is shifted to keep ADC_TEMP_FRAC extra bits of iron_temp
+ * The ambient slots hold the heater current zero offset except one period in ADC_AMB_PERIOD, see adcSchedule()
  */
+static void adcProcess(volatile uint16_t* data) {
+	uint32_t iron_temp	= adcTempSum(data);
+	uint32_t partner	= 0;								// ambient or the heater current offset
+	for (uint16_t i = 0; i < ADC_HALF_SZ; i += 4)
+		partner		+= data[i]		+ data[i+3];
+	const uint8_t shift = ADC_TEMP_OS_P - ADC_TEMP_FRAC;
+	iron_temp 	+= 1 << (shift-1);							// Round the result
+	iron_temp 	>>= shift;
+	partner		+= ADC_TEMP_OS/2;
+	partner		>>= ADC_TEMP_OS_P;
+	if (amb_window) {
+		core.iron.updateAmbient(partner);
+		raw_ambient = partner;
+	} else
+		core.iron.updateIdleCurrent(partner);
+	if (--amb_count == 0)
+		amb_count = ADC_AMB_PERIOD;
+	if (amb_warmup) --amb_warmup;
+	adcSchedule(amb_warmup || amb_count == 1);				// Ambient is sampled in the last period of ADC_AMB_PERIOD
+	core.iron.updateSensor((iron_temp >> ADC_TEMP_FRAC) >= ADC_TC_OPEN);
+	if (settle_delay && adc_rate == ADC_RATE_NORMAL) {		// The first sequence is not settled, do not control the IRON
+		adcSettle(data);
+		return;
+	}
+
+	bool connected = core.iron.isIronConnected();
+	uint32_t iron_power = 0;								// The power with ADC_PWM_DITHER fractional bits
+	if (connected) {
+		uint32_t start = DWT->CYCCNT;
+		iron_power = core.iron.power(iron_temp, ADC_TEMP_FRAC, ADC_PWM_DITHER);
+		cycleStat(&adc_timing.power, DWT->CYCCNT - start);
+	}
+	adcRateApply(adcRatePolicy(connected, iron_power >> ADC_PWM_DITHER));
+	if (connected) {										// Distribute the power of the measurement cycle among its periods
+		int32_t pwm	= adcDither(iron_power);
+		pwm_meas	= constrain(pwm / adc_every, 0, max_iron_pwm);
+		if (adc_every > 1)
+			pwm_other = constrain((pwm - pwm_meas) / (adc_every - 1), 0, adc_period);
+	} else if (core.iron.isCurrentLost() && --check_count == 0) {	// The tip is inserted: probe the heater current, it could be a contact dropout
+		check_count	= check_period;
+		pwm_meas	= curr_min_pwm;
+		pwm_other	= curr_min_pwm;
+	} else {
+		pwm_meas	= 0;									// The tip presence is checked by the thermocouple, no power is required
+		pwm_other	= 0;
+	}
+	if (adc_every > 1) {
+		TIM2->CCR2	= ADC_NO_TRIGGER;						// No measurement window till the last period of the cycle
+		TIM2->CCR1	= pwm_other;							// The next period is the first one of the measurement cycle
+	} else {
+		TIM2->CCR1	= pwm_meas;
+	}
+
+	ADC_SAMPLE s;
+	s.stamp		= adc_stamp;
+	s.temp		= iron_temp;
+	s.current	= raw_current;
+	s.ambient	= raw_ambient;
+	s.power		= iron_power >> ADC_PWM_DITHER;
+	s.pwm		= pwm_meas;
+	s.rate		= adc_rate;
+	s.frac		= ADC_TEMP_FRAC;
+	samples.push(s);
+}
+
+/*
+ * IRQ handlers of circular DMA. The DMA keeps on writing the other half of the buffer
+ * on the next TIM2 period, so the half just completed is safe to read till the end of that period.
+ * The handler just passes the completed half to the bottom half running in PendSV exception on the lowest priority,
+ * so the control law does not block the other interrupts (the encoder).
+ * The bottom half should complete before the next half is ready (one TIM2 period), otherwise it is late:
+ * the new CCR1 value would be applied on the PWM period after the next one
+ */
+static void adcComplete(volatile uint16_t* data) {
+	uint32_t start = DWT->CYCCNT;
+	if (adc_ready != adc_done)								// The previous half has not been processed yet
+		++adc_timing.bh_late;
+	if (adc_ready) {										// The interval between two interrupts should be exactly one measurement cycle
+		int32_t dev		= (int32_t)(start - adc_stamp) - (int32_t)adc_interval;
+		cycleStat(&adc_timing.jitter, (dev < 0)?-dev:dev);
+	}
+	adc_stamp	= start;
+	adc_half	= data;
+	++adc_ready;
+	SCB->ICSR	= SCB_ICSR_PENDSVSET_Msk;					// Run the bottom half when all the interrupts are served
+	cycleStat(&adc_timing.isr, DWT->CYCCNT - start);
+}
+
+extern "C" void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc) {
+	adcComplete(&buff[0]);
+}
+
 extern "C" void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc) {
-	HAL_ADCEx_MultiModeStop_DMA(&hadc1);
-	HAL_ADC_Stop(&hadc2);
-	if (adc_mode == ADC_TEMP) {
-		uint32_t iron_temp	= 0;
-		uint32_t ambient	= 0;
-		for (uint8_t i = 0; i < ADC_BUFF_SZ; i += 2*ADC_CONV) {
-			iron_temp	+= buff[i+1] 	+ buff[i+3];
-			ambient		+= buff[i+2];
-		}
-		iron_temp 	+= ADC_LOOPS;							// Round the result
-		iron_temp 	/= ADC_LOOPS*2;
-		ambient		+= ADC_LOOPS/2;
-		ambient		/= ADC_LOOPS;
-		core.iron.updateAmbient(ambient);
-
-		uint8_t min_iron_pwm = 0;							// By default do not power the IRON to check connectivity
-		if (--check_count == 0) {							// It is time to check IRON is connected or not
-			check_count	 = check_period;
-			min_iron_pwm = check_iron_pwm;
-		}
-		if (core.iron.isIronConnected()) {
-			uint16_t iron_power = core.iron.power(iron_temp);
-			TIM2->CCR1	= constrain(iron_power, min_iron_pwm, max_iron_pwm);
+	adcComplete(&buff[ADC_HALF_SZ]);
+}
 
-		} else {
-			TIM2->CCR1	= min_iron_pwm;						// Sometimes supply minimum power to the IRON to check connectivity
-		}
-	} else if (adc_mode == ADC_CURRENT) {
-		uint32_t iron_curr	= 0;
-		for (uint8_t i = 0; i < ADC_BUFF_SZ; i += 2*ADC_CONV) {
-			iron_curr	+= buff[i];
-		}
-		iron_curr	+= ADC_LOOPS/2;							// Round the result
-		iron_curr	/= ADC_LOOPS;
+// The bottom half of the ADC interrupt: filtering, the IRON power calculation and CCR1 update. See stm32f1xx_hal_msp.c for the priority
+extern "C" void PendSV_Handler(void) {
+	uint32_t start = DWT->CYCCNT;
+	uint32_t ready = adc_ready;
+	if (ready == adc_done) return;
+	adcProcess(adc_half);
+	adc_done = ready;
+	uint32_t end = DWT->CYCCNT;
+	cycleStat(&adc_timing.bh, end - start);
+	cycleStat(&adc_timing.response, end - adc_stamp);
+}
+
+// Apply the blanking window: the time the amplifier needs to settle after the IRON power off, 0 - default
+extern "C" void adcBlanking(uint8_t ticks) {
+	if (ticks < ADC_BLANK_MIN || ticks > ADC_BLANK_MAX)
+		ticks = ADC_BLANK;
+	adc_blank	 = ticks;
+	max_iron_pwm = adc_window - ticks;
+	adcPowerLimit();
+}
 
-		if (TIM2->CCR1)										// If IRON has been powered
-			core.iron.updateIronCurrent(iron_curr);
+extern "C" uint16_t adcMaxPower(void) {
+	return max_iron_pwm;
+}
+
+// Start the amplifier settle time measurement, the reference requires at least two sequences per window
+extern "C" bool adcSettleStart(void) {
+	if (ADC_SEQ < 2 || !settle_done) return false;
+	memset(settle_dev, 0, sizeof(settle_dev));
+	settle_loop		= 0;
+	settle_skip		= 2;
+	settle_result	= 0;
+	settle_done		= false;
+	settle_delay	= ADC_BLANK_MIN;						// The bottom half starts the measurement
+	return true;
+}
+
+extern "C" void adcSettleStop(void) {
+	settle_delay	= 0;
+	TIM2->CCR1		= 0;
+	adcFirstTrigger(adc_window);
+	settle_done		= true;
+}
+
+// The measurement progress in percents
+extern "C" uint8_t adcSettleProgress(void) {
+	if (settle_done) return 100;
+	uint8_t d = settle_delay;
+	return (uint16_t)(d - ADC_BLANK_MIN) * 100 / (ADC_BLANK_MAX - ADC_BLANK_MIN + 1);
+}
+
+// The measured blanking window (TIM2 ticks) or 0 if the amplifier does not settle in ADC_BLANK_MAX ticks
+extern "C" uint8_t adcSettleResult(void) {
+	return settle_result;
+}
+
+// Fix the control rate or let the controller select it (ADC_RATE_AUTO). The bottom half switches the rate
+extern "C" void adcRate(ADC_RATE rate) {
+	if (rate <= ADC_RATE_AUTO)
+		rate_fixed = rate;
+}
+
+extern "C" ADC_RATE adcActiveRate(void) {
+	return adc_rate;
+}
+
+// Select the front-end of the IRON temperature samples
+extern "C" void adcFilter(ADC_FILTER filter) {
+	if (filter <= ADC_FILTER_TRIMMED)
+		temp_filter = filter;
+}
+
+extern "C" uint32_t adcRejected(void) {
+	return temp_rejected;
+}
+
+extern "C" bool adcSample(ADC_SAMPLE* s) {
+	return samples.pop(s);
+}
+
+extern "C" uint16_t adcSamples(void) {
+	return samples.size();
+}
+
+extern "C" uint32_t adcSampleOverrun(void) {
+	return samples.overrun();
+}
+
+extern "C" const ADC_TIMING* adcTiming(void) {
+	return &adc_timing;
+}
+
+extern "C" void adcTimingReset(void) {
+	memset(&adc_timing, 0, sizeof(ADC_TIMING));
+}
+
+/*
+ * IRQ handler of ADC injected group complete. The injected group is started by TIM2 TRGO (OC3REF rising edge)
+ * at the beginning of the PWM period to read the current through the IRON
+ * ADC1 injected ranks:	iron_current, iron_current
+ * ADC2 injected ranks:	iron_temp, iron_temp (the amplifier is saturated while the IRON is powered)
+ * When the measurement window is not in every period, the handler schedules the periods of the measurement cycle:
+ * it enables the window in the last period and loads CCR1 for the next one
+ */
+extern "C" void HAL_ADCEx_InjectedConvCpltCallback(ADC_HandleTypeDef* hadc) {
+	if (TIM2->CCR1 >= curr_min_pwm) {						// If IRON has been powered long enough
+		uint32_t iron_curr	= HAL_ADCEx_InjectedGetValue(&hadc1, ADC_INJECTED_RANK_1);
+		iron_curr		   += HAL_ADCEx_InjectedGetValue(&hadc1, ADC_INJECTED_RANK_2);
+		iron_curr			= (iron_curr + 1) >> 1;			// Round the result
+		raw_current			= iron_curr;
+		core.iron.updateIronCurrent(iron_curr);
+	}
+	uint8_t every = adc_every;
+	if (every > 1) {
+		if (++pwm_count >= every) pwm_count = 0;
+		if (pwm_count == every - 1)							// The last period of the cycle, the bottom half disables the window again
+			TIM2->CCR2	= adc_window;
+		TIM2->CCR1	= (pwm_count + 2 == every)?pwm_meas:pwm_other;
 	}
-	adc_mode = ADC_IDLE;
 }
 
 extern "C" void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc) 				{ }
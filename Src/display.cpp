@@ -150,12 +150,22 @@ static const uint8_t R[] = {
 	0xfc, 0x1f, 0xc0, 0xfc, 0x0f, 0xe0, 0xfc, 0x0f, 0xe0
 };
 
-static const char* k_proto[3] = {
+static const char* k_proto[5] = {
 	"Kp = %5d",
 	"Ki = %5d",
-	"Kd = %5d"
+	"Kd = %5d",
+	"b=%d.%d",												// The setpoint weights in tenths, see PIDparam
+	"c=%d.%d"
 };
 
+// Print the PID coefficient: the gains are integer, the setpoint weights are shown as a decimal fraction
+static void pidValue(char *buff, uint8_t index, uint16_t value) {
+	if (index < 3)
+		sprintf(buff, k_proto[index], value);
+	else
+		sprintf(buff, k_proto[index], value / 10, value % 10);
+}
+
 void DSPL::init(const u8g2_cb_t *rotation) {
 	u8x8_msg_cb msg_cb = u8x8_byte_stm32_hw_spi;
 	if (HAL_OK == HAL_I2C_IsDeviceReady(&hi2c1, OLED_I2C_ADDR<<1, 2, 2)) {
@@ -215,6 +225,14 @@ void DSPL::timeToOff(uint8_t time) {
 	sprintf(msg_buff, "%2d", time);
 }
 
+void DSPL::readyTime(uint32_t ms) {
+	uint16_t ds = constrain((ms + 50) / 100, 0, 9999);		// Tenths of a second, 999 seconds at most
+	if (ds < 1000)
+		snprintf(msg_buff, sizeof(msg_buff), "%u.%us", ds / 10u, ds % 10u);
+	else
+		snprintf(msg_buff, sizeof(msg_buff), "%us", ds / 10u);
+}
+
 void DSPL::tip(const char *tip_name) {
 	strncpy(this->tip_name, tip_name, 9);
 	this->tip_name[9] = '\0';
@@ -408,9 +426,9 @@ void DSPL::pidSetLowerAxisLabel(const char *label) {
 }
 
 void DSPL::pidModify(uint8_t index, uint16_t value) {
-	if (index < 3) {
+	if (index < 5) {
 		default_mode	= HAL_GetTick() + 1000;						// Show new value for 1 second
-		sprintf(modified_value, k_proto[index], value);
+		pidValue(modified_value, index, value);
 	}
 }
 
@@ -559,7 +577,7 @@ void DSPL::pidShowGraph(uint8_t pwr) {
 	U8G2::sendBuffer();
 }
 
-void DSPL::pidShowMenu(uint16_t pid_k[3], uint8_t index) {
+void DSPL::pidShowMenu(uint16_t pid_k[5], uint8_t index, uint8_t confidence) {
 	static const char* title = "Tune PID";
 	char buff[12];
 
@@ -569,14 +587,19 @@ void DSPL::pidShowMenu(uint16_t pid_k[3], uint8_t index) {
 	uint8_t width = U8G2::getStrWidth(title);
 	U8G2::drawStr((d_width-width)/2, 13, title);
 	U8G2::drawHLine((d_width-width)/2, 15, width);
-	// Show the Coefficient values
-	for (uint8_t i = 0; i < 3; ++i) {
-		sprintf(buff, k_proto[i], pid_k[i]);
-		U8G2::drawStr(20, 28+i*13, buff);
+	// Show the Coefficient values: the gains in the left column, the setpoint weights in the right one
+	for (uint8_t i = 0; i < 5; ++i) {
+		uint8_t x	= (i < 3)?10:93;
+		uint8_t row	= (i < 3)?i:(i - 3);
+		pidValue(buff, i, pid_k[i]);
+		U8G2::drawStr(x, 28+row*13, buff);
 		if (index == i) {
-			U8G2::drawBitmap(0, 20+i*13, 1, 7, bmLeftMark);
+			U8G2::drawBitmap(x-10, 20+row*13, 1, 7, bmLeftMark);
 		}
 	}
+	// The confidence of the IRON model identified online (see RLS), 100% does not fit the column
+	sprintf(buff, "m=%2d%%", (confidence > 99)?99:confidence);
+	U8G2::drawStr(93, 28+2*13, buff);
 	U8G2::sendBuffer();
 }
 
@@ -855,6 +878,38 @@ void DSPL::debugShow(uint16_t power, bool iron, bool tilt, uint16_t data[4]) {
 	U8G2::sendBuffer();
 }
 
+void DSPL::debugTiming(const ADC_TIMING* t) {
+	static const char* name[3] = { "ISR", "BH", "PID" };
+	const CYCLE_STAT* stat[3] = { &t->isr, &t->bh, &t->power };
+	char buff[24];
+
+	U8G2::setFont(u8g_font_profont15r);
+	U8G2::clearBuffer();
+	for (uint8_t i = 0; i < 3; ++i) {
+		sprintf(buff, "%-3s%7lu%7lu", name[i], (unsigned long)stat[i]->avg, (unsigned long)stat[i]->max);
+		U8G2::drawStr(0,  15*(i+1), buff);
+	}
+	sprintf(buff, "J%9lu L%5lu", (unsigned long)t->jitter.max, (unsigned long)t->bh_late);
+	U8G2::drawStr(0,  60, buff);
+	U8G2::sendBuffer();
+}
+
+void DSPL::debugLoad(const IRON_LOAD& e, uint8_t n) {
+	char buff[24];
+
+	U8G2::setFont(u8g_font_profont15r);
+	U8G2::clearBuffer();
+	sprintf(buff, "Load%10d", n);
+	U8G2::drawStr(0,  15, buff);
+	sprintf(buff, "D%5d P%6d", e.depth, e.peak);
+	U8G2::drawStr(0,  30, buff);
+	sprintf(buff, "T%5d.%d", e.duration / 1000, (e.duration % 1000) / 100);
+	U8G2::drawStr(0,  45, buff);
+	sprintf(buff, "R%5d.%d", e.recovery / 1000, (e.recovery % 1000) / 100);
+	U8G2::drawStr(0,  60, buff);
+	U8G2::sendBuffer();
+}
+
 void DSPL::showVersion(void) {
 	static const char *title = "About";
 	char buff[30];
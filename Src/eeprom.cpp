@@ -10,6 +10,36 @@
 #include "eeprom.h"
 #include "iron_tips.h"
 
+// The first version of the tip record, see upgradeTipArea()
+typedef struct s_tip_v1 TIP_V1;
+struct s_tip_v1 {
+	uint16_t	t200, t260, t330, t400;
+	uint8_t		mask;								// TIP_ACTIVE + TIP_CALIBRATED, the holding power model in the upper 6 bits
+	char		name[tip_name_sz];
+	int8_t		ambient;
+	uint8_t		crc;
+};
+static_assert(sizeof(TIP_V1) == 16, "The first version tip record has 16 bytes");
+static const uint8_t	tip_v1_per_chunk	= eeprom_chunk_size / sizeof(TIP_V1);
+static const uint8_t	tip_v1_hold_shift	= 2;
+
+// The tip record of the first version is correct: the checksum and the tip name
+static bool isTipV1(TIP_V1* tip) {
+	uint32_t summ = tip->t200;
+	summ <<= 1; summ += tip->t260;
+	summ <<= 1; summ += tip->t330;
+	summ <<= 1; summ += tip->t400;
+	summ <<= 1; summ += tip->mask;
+	summ <<= 1; summ += tip->ambient;
+	for (int i = 0; i < tip_name_sz; ++i) {
+		summ <<= 1; summ += (uint8_t)tip->name[i];
+	}
+	summ += 117;
+	if (tip->crc != (summ & 0xFF)) return false;
+	if ((tip->mask & (TIP_ACTIVE | TIP_CALIBRATED)) == 0) return false;
+	return (tip->name[0] >= '0' && tip->name[0] <= 'Z');
+}
+
 bool EEPROM::init(void) {
 	// Read all the records in the EEPROM and find min and max record IDs
 	uint32_t 	min_rec_ID 	= 0xffffffff;
@@ -24,7 +54,7 @@ bool EEPROM::init(void) {
 	}
 
 	can_write = true;
-	for (uint16_t chunk = 0; chunk < cfg_chunks; ++chunk) {
+	for (uint16_t chunk = 0; chunk < cfg_records; ++chunk) {
 		if (readChunk(chunk)) {
 			RECORD* cfg = (RECORD*)data;
 			if (CFG_checkSum(cfg, false)) {
@@ -48,15 +78,25 @@ bool EEPROM::init(void) {
 
 	if (records == 0) {
 		w_chunk		= r_chunk = 0;
-	    return can_write;
+	} else {
+		r_chunk = max_rec_ch;
+		if (records < cfg_records) {						// The EEPROM is not full
+			w_chunk = r_chunk + 1;
+			if (w_chunk >= cfg_records) w_chunk = 0;
+		} else {
+			w_chunk = min_rec_ch;
+		}
 	}
 
-	r_chunk = max_rec_ch;
-	if (records < cfg_chunks) {								// The EEPROM is not full
-	    w_chunk = r_chunk + 1;
-	    if (w_chunk >= cfg_chunks) w_chunk = 0;
-	} else {
-		w_chunk = min_rec_ch;
+	/*
+	 * The configuration records used the schedule chunk before the PID gain schedule was introduced.
+	 * If it keeps the newest record, the record is moved to the configuration records before the schedule overwrites it
+	 */
+	if (can_write && readChunk(sched_chunk)) {
+		RECORD last;
+		memcpy(&last, data, sizeof(RECORD));
+		if (CFG_checkSum(&last, false) && (records == 0 || last.ID > max_rec_ID))
+			saveRecord(&last);								// Increments the ID, so the record is moved once
 	}
 	return can_write;
 }
@@ -86,16 +126,33 @@ bool EEPROM::saveRecord(RECORD* config_record) {
 	memcpy(data, (uint8_t*)config_record, sizeof(RECORD));
 	if (writeChunk(w_chunk)) {
 		r_chunk = w_chunk;
-		if (++w_chunk >= cfg_chunks) w_chunk = 0;
+		if (++w_chunk >= cfg_records) w_chunk = 0;
 		return true;
 	}
 	return false;
 }
 
-/*
- * Load tip configuration from EEPROM.
- * As soon one tip record fits to 16 bytes, two tips are saved in one chunk
- */
+bool EEPROM::loadSchedule(PID_SCHEDULE* schedule) {
+	if (readChunk(sched_chunk)) {
+		PID_SCHEDULE* s = (PID_SCHEDULE*)data;
+		if (SCHED_checkSum(s, false)) {
+			memcpy(schedule, s, sizeof(PID_SCHEDULE));
+			return true;
+		}
+	}
+	return false;
+}
+
+bool EEPROM::saveSchedule(PID_SCHEDULE* schedule) {
+	if (!can_write) return can_write;
+
+	SCHED_checkSum(schedule, true);
+	memset(data, 0xFF, eeprom_chunk_size);
+	memcpy(data, (uint8_t*)schedule, sizeof(PID_SCHEDULE));
+	return writeChunk(sched_chunk);
+}
+
+// Load tip configuration from EEPROM.
 TIP_IO_STATUS EEPROM::loadTipData(TIP* tip, uint8_t tip_chunk_index) {
 	uint16_t tip_space 		= requiredTipSpace();
 	uint16_t tips_per_chunk = eeprom_chunk_size / tip_space;
@@ -124,7 +181,8 @@ TIP_IO_STATUS EEPROM::saveTipData(TIP* tip, uint8_t tip_chunk_index) {
 	uint8_t	 index 			= (tip_chunk_index % tips_per_chunk) * tip_space;
 
 	if (readChunk(tip_chunk)) {								// load whole EEPROM chunk
-		TIP* tmp_tip = (TIP *)&data[index];					// choose correct record index (1 or 2)
+		TIP* tmp_tip = (TIP *)&data[index];
+		tip->version = TIP_VERSION;
 		memcpy(tmp_tip, tip, sizeof(TIP));					// Replace tip configuration in the data buffer
 		TIP_checkSum(tmp_tip, true);						// calculate CRC inside the data buffer
 		if (writeChunk(tip_chunk))							// Rewrite whole chunk
@@ -133,6 +191,106 @@ TIP_IO_STATUS EEPROM::saveTipData(TIP* tip, uint8_t tip_chunk_index) {
 	return EPR_IO;											// Here can be any of IO error: read or write
 }
 
+/*
+ * The first version tip records (16 bytes, two records per chunk) are converted in place, one record per chunk.
+ * 1. The records with index 64 and above move to the free places of the first 64 records: one record per chunk leaves 64 places.
+ *    If there are more than 64 tips in the EEPROM, the rest is lost. The moved record is cleared at its old place.
+ *    If the power was lost between the copy and the clear, the first record left has the copy already, so it is cleared only.
+ *    If the power was lost in step 2, the converted chunks are skipped: the start of the converted chunk could read as the old record.
+ * 2. The record i is converted to the chunk i from the highest index to the lowest one. The chunk i keeps the old records 2i and 2i+1,
+ *    that are already converted, and the old record i is in the chunk i/2, that is not converted yet.
+ * The converted chunks are skipped, so the upgrade can be safely repeated if the power was lost in the middle.
+ */
+uint8_t EEPROM::upgradeTipArea(void) {
+	if (!can_write) return 0;
+	uint16_t first_chunk = eeprom_chunks - tip_chunks;
+	bool found = false;
+	for (uint16_t ch = first_chunk; ch < eeprom_chunks && !found; ++ch) {
+		if (!readChunk(ch)) return 0;
+		if (isTipChunkUpgraded()) continue;
+		for (uint8_t i = 0; i < tip_v1_per_chunk; ++i) {
+			if (isTipV1((TIP_V1*)&data[i * sizeof(TIP_V1)])) {
+				found = true;
+				break;
+			}
+		}
+	}
+	if (!found) return 0;
+
+	uint16_t tips = tip_chunks * (eeprom_chunk_size / requiredTipSpace());
+	uint16_t free_index = 0;
+	bool first = true;
+	for (uint16_t k = tips; k < tip_chunks * tip_v1_per_chunk; ++k) {	// Step 1
+		TIP_V1 tip;
+		uint16_t src_chunk	= first_chunk + k / tip_v1_per_chunk;
+		uint8_t	 src_offset	= (k % tip_v1_per_chunk) * sizeof(TIP_V1);
+		if (!readChunk(src_chunk)) return 0;
+		if (isTipChunkUpgraded()) continue;					// Converted by step 2 before the power loss
+		memcpy(&tip, &data[src_offset], sizeof(TIP_V1));
+		if (!isTipV1(&tip)) continue;
+		bool copied = false;
+		if (first) {										// Look for the copy saved before the power loss
+			first = false;
+			for (uint16_t i = 0; i < tips && !copied; ++i) {
+				if (!readChunk(first_chunk + i / tip_v1_per_chunk)) return 0;
+				if (isTipChunkUpgraded()) continue;
+				copied = (memcmp(&data[(i % tip_v1_per_chunk) * sizeof(TIP_V1)], &tip, sizeof(TIP_V1)) == 0);
+			}
+		}
+		for (; !copied && free_index < tips; ++free_index) {
+			if (!readChunk(first_chunk + free_index / tip_v1_per_chunk)) return 0;
+			if (isTipChunkUpgraded()) continue;
+			TIP_V1* place = (TIP_V1*)&data[(free_index % tip_v1_per_chunk) * sizeof(TIP_V1)];
+			if (!isTipV1(place)) {
+				memcpy(place, &tip, sizeof(TIP_V1));
+				if (!writeChunk(first_chunk + free_index / tip_v1_per_chunk)) return 0;
+				copied = true;
+			}
+		}
+		if (!copied) break;									// No free place
+		if (!readChunk(src_chunk)) return 0;				// Clear the old place, so the record is not moved again
+		memset(&data[src_offset], 0xFF, sizeof(TIP_V1));
+		if (!writeChunk(src_chunk)) return 0;
+	}
+
+	uint8_t converted = 0;
+	for (int16_t i = tips-1; i >= 0; --i) {					// Step 2
+		if (!readChunk(first_chunk + i)) return converted;
+		if (isTipChunkUpgraded()) continue;
+		TIP_V1 old;
+		bool is_old = false;
+		if (!readChunk(first_chunk + i / tip_v1_per_chunk)) return converted;
+		if (!isTipChunkUpgraded()) {
+			memcpy(&old, &data[(i % tip_v1_per_chunk) * sizeof(TIP_V1)], sizeof(TIP_V1));
+			is_old = isTipV1(&old);
+		}
+		memset(data, 0xFF, eeprom_chunk_size);
+		if (is_old) {
+			TIP* tip = (TIP*)data;
+			memset(tip, 0, sizeof(TIP));
+			tip->t200		= old.t200;
+			tip->t260		= old.t260;
+			tip->t330		= old.t330;
+			tip->t400		= old.t400;
+			tip->mask		= old.mask & (TIP_ACTIVE | TIP_CALIBRATED);
+			tip->hold		= old.mask >> tip_v1_hold_shift;
+			tip->ambient	= old.ambient;
+			memcpy(tip->name, old.name, tip_name_sz);
+			tip->version	= TIP_VERSION;
+			TIP_checkSum(tip, true);
+		}
+		if (!writeChunk(first_chunk + i)) return converted;
+		if (is_old) ++converted;
+	}
+	return converted;
+}
+
+bool EEPROM::isTipChunkUpgraded(void) {
+	TIP tip;
+	memcpy(&tip, data, sizeof(TIP));
+	return TIP_checkSum(&tip, false);
+}
+
 
 // Clear bottom area of the EEPROM, where the configuration data is
 void EEPROM::clearConfigArea(void) {
@@ -201,19 +359,39 @@ uint8_t EEPROM::CFG_checkSum(RECORD* cfg, bool write) {
 	return res;
 }
 
-// Checks the CRC inside tip structure. Returns true if OK, replaces the CRC with the correct value
+/*
+ * Checks the CRC of the PID gain schedule. Returns true if OK. Replace the CRC with the correct value if write is true
+ * The sum is rotated as the one of the tip record, so every byte of the schedule is checked
+ */
+bool EEPROM::SCHED_checkSum(PID_SCHEDULE* schedule, bool write) {
+	uint16_t 	summ 		= 117;							// To avoid good check sum with all-zero, start with 117
+	uint16_t    rec_summ 	= schedule->crc;
+	schedule->crc			= 0;
+	uint8_t*	d 			= (uint8_t*)schedule;
+	for (uint8_t i = 0; i < sizeof(PID_SCHEDULE); ++i) {
+		summ = (summ << 1) | (summ >> 15);
+		summ += d[i];
+	}
+	bool res = (rec_summ == summ);
+	schedule->crc = write?summ:rec_summ;					// Keep the buffer, the chunk can be loaded again from the cache
+	return res;
+}
+
+/*
+ * Checks the CRC inside tip structure and the record version. Returns true if OK, replaces the CRC with the correct value if write is true
+ * The sum is rotated, so every byte of the record is checked
+ */
 uint8_t EEPROM::TIP_checkSum(TIP* tip, bool write) {
-	uint32_t summ = tip->t200;
-	summ <<= 1; summ += tip->t260;
-	summ <<= 1; summ += tip->t330;
-	summ <<= 1; summ += tip->t400;
-	summ <<= 1; summ += tip->mask;
-	summ <<= 1; summ += tip->ambient;
-	for (int i = 0; i < tip_name_sz; ++i) {
-		summ <<= 1; summ += (uint8_t)tip->name[i];
+	uint8_t		rec_summ	= tip->crc;
+	tip->crc				= 0;
+	uint16_t	summ		= 117;							// To avoid good check sum with all-zero
+	uint8_t*	d			= (uint8_t*)tip;
+	for (uint8_t i = 0; i < sizeof(TIP); ++i) {
+		summ = (summ << 1) | (summ >> 15);
+		summ += d[i];
 	}
-	summ += 117;											// To avoid good check sum with all-zero
-	uint8_t res = (tip->crc == (summ & 0xFF));
-	if (write) tip->crc = summ & 0xFF;
+	uint8_t crc = summ ^ (summ >> 8);
+	uint8_t res = (rec_summ == crc) && (tip->version == TIP_VERSION);
+	tip->crc = write?crc:rec_summ;
 	return res;
 }
@@ -20,6 +20,10 @@ RENC::RENC(GPIO_TypeDef* aPORT, uint16_t aPIN, GPIO_TypeDef* bPORT, uint16_t bPI
 
 void RENC::addButton(GPIO_TypeDef* ButtonPORT, uint16_t ButtonPIN) {
 	bpt 		= 0;
+	b_check		= 0;										// The button state is initialized on start, the tick counter restarts
+	b_on		= false;
+	i_b_rel		= false;
+	avg.reset();
 	b_port 		= ButtonPORT;
 	b_pin  		= ButtonPIN;
 	over_press	= def_over_press;
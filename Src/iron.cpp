@@ -9,11 +9,22 @@
 #include "iron.h"
 #include "tools.h"
 
+/*
+ * The exponential average coefficients are defined for the reference control period (PID::ref_period)
+ * Scale the coefficient to the active control period to keep the averaging time
+ */
+static uint8_t empLength(uint8_t length, uint32_t period) {
+	uint32_t l = ((uint32_t)length * PID::ref_period + period/2) / period;
+	return constrain(l, 1, 255);
+}
+
 void IRON_HW::init(void) {
 	tilt_changed	= false;
-	t_iron_short.length(iron_emp_coeff);
 	t_amb.length(ambient_emp_coeff);
 	c_iron.init(iron_sw_len,	iron_off_value,	iron_on_value);
+	tc_present		= false;
+	tc_open			= 0;
+	c_idle.length(idle_emp_coeff);
 	sw_iron.init(sw_avg_len,	sw_off_value, 	sw_on_value);
 }
 
@@ -28,7 +39,7 @@ static const uint16_t beta 			= 3950;     			// The beta coefficient of the ther
 static int32_t	average 			= 0;					// Previous value of analog read
 static int 		cached_ambient 		= 0;					// Previous value of the temperature
 
-	if (!c_iron.status()) return default_ambient;			// If IRON is not connected, return default ambient temperature
+	if (!isIronConnected()) return default_ambient;			// If IRON is not connected, return default ambient temperature
 	if (abs(t_amb.read() - average) < 20)
 		return cached_ambient;
 
@@ -53,6 +64,33 @@ static int 		cached_ambient 		= 0;					// Previous value of the temperature
 }
 
 
+void IRON_HW::updateIronCurrent(uint16_t value) {
+	int32_t idle = c_idle.read();
+	value = (value > idle)?value - idle:0;
+	c_iron.update(value);
+}
+
+/*
+ * The tip presence is detected by the thermocouple: the heater and the thermocouple of T12 tip share the same contacts,
+ * so when the tip is removed, the open amplifier input saturates. The current switch is updated while the IRON is powered only,
+ * it is set on tip insertion and detects the broken heater. So no power is required to check the tip presence.
+ * While the tip is inserted, but the current is lost, the heater is probed by the short pulse (see adcProcess()),
+ * so the heater contact dropout does not switch the IRON off for good
+ */
+void IRON_HW::updateSensor(bool open) {
+	if (open) {
+		if (tc_open < tc_open_len) ++tc_open;
+		if (tc_open >= tc_open_len)
+			tc_present = false;
+	} else {
+		tc_open = 0;
+		if (!tc_present) {
+			c_iron.set(true);
+			tc_present = true;
+		}
+	}
+}
+
 void IRON_HW::checkSWStatus(void) {
 	if (HAL_GetTick() > check_sw) {
 		check_sw = HAL_GetTick() + check_sw_period;
@@ -83,35 +121,63 @@ void IRON::init(void) {
 	d_power.length(ec);
 	d_temp.length(ec);
 	PID::init();											// Initialize PID for IRON
+	PID::powerLimits(0, pid_limit);
 	resetPID();
+	est.model(PIDmodel());
+	est.reset();
 }
 
 void IRON::switchPower(bool On) {
 	if (!On) {
+		track_on	= false;								// The identification is paused till the working mode starts it again
+		heat		= HEAT_OFF;
+		load_phase	= LOAD_OFF;
 		fix_power	= 0;
 		if (mode != POWER_OFF)
 				mode = POWER_COOLING;						// Start the cooling process
-	} else {
-		resetPID();
+		h_power.reset();
+	} else if (mode != POWER_ON) {
+		bool warm	= (mode == POWER_COOLING);				// Switched on again before the IRON has cooled down
 		mode		= POWER_ON;
+		reenter();
+		heatStart(warm?temp_curr:0);
+	} else if (!chill) {									// The PID is running already, setTemp() has transferred it
+		heatStart();
 	}
-	h_power.reset();
 	d_power.reset();
 }
 
 void IRON::autoTunePID(uint16_t base_pwr, uint16_t delta_power, uint16_t base_temp, uint16_t temp) {
 	mode = POWER_PID_TUNE;
+	heat = HEAT_OFF;
+	load_phase = LOAD_OFF;
 	h_power.reset();
 	d_power.reset();
 	PIDTUNE::start(base_pwr,delta_power, base_temp, temp);
 }
 
-void IRON::setTemp(uint16_t t) {
-	if (mode == POWER_ON) resetPID();
+/*
+ * The PID is not reset: the setpoint change goes through the weighted proportional and derivative terms, see PIDparam.
+ * If the PID keeps the temperature, the average power applied is the actual holding power. The holding power is proportional
+ * to the temperature over ambient (see PIDmodel), so the integral term is transferred to the power scaled to the new temperature.
+ * It is the holding power of the tip in use, not the learned model, so the PID re-enters without the bump (see reenter())
+ * The bottom half should not run the PID between the feed-forward change and the transfer, see PID_LOCK
+ */
+void IRON::setTemp(uint16_t t, uint16_t hold) {
+	PID_LOCK lock;
 	if (t > int_temp_max) t = int_temp_max;					// Do not allow over heating. int_temp_max is defined in vars.cpp
+	bool	keep	= isKeeping();
+	int32_t	at		= h_temp.read();
+	hold_power		= (keep && at > 0)?(int32_t)h_power.read() * t / at:0;
+	PID::feedForward(hold);									// The PID corrects the residual only
 	temp_set = t;
-	uint16_t ta = h_temp.read();
-	chill = (ta > t + 20);                         			// The IRON must be cooled
+	load_phase	= LOAD_OFF;									// The event is not logged, the setpoint change is not the load
+	load_quiet	= HAL_GetTick();
+	if (sched_on) applySchedule(t);
+	chill = (temp_curr > t + 20);							// The IRON must be cooled
+	if (keep && !chill)
+		PID::transfer(hold_power);
+	if (mode == POWER_ON) heatStart();
 }
 
 uint16_t IRON::avgPower(void) {
@@ -136,6 +202,8 @@ uint8_t IRON::avgPowerPcnt(void) {
 }
 
 void IRON::fixPower(uint16_t Power) {
+	heat = HEAT_OFF;
+	load_phase = LOAD_OFF;
 	h_power.reset();
 	d_power.reset();
 	if (Power == 0) {										// To switch off the IRON, set the Power to 0
@@ -154,10 +222,64 @@ void IRON::fixPower(uint16_t Power) {
 void IRON::adjust(uint16_t t) {
 	if (t > int_temp_max) t = int_temp_max;					// Do not allow over heating
 	temp_set = t;
+	if (sched_on) applySchedule(t);
+}
+
+void IRON::schedule(const PID_SCHEDULE* s) {
+	bool on = sched_on;
+	useSchedule(false);
+	sched_valid = false;
+	if (s) {
+		sched		= *s;
+		sched_valid	= true;
+		for (uint8_t i = 0; i < PID_BANDS; ++i) {
+			if (sched.temp[i] == 0 || (i > 0 && sched.temp[i] <= sched.temp[i-1])) {
+				sched_valid = false;
+				break;
+			}
+		}
+	}
+	useSchedule(on);
+}
+
+// The working modes follow the schedule, the modes that load their own PID parameters (calibration, tuning) turn it off
+void IRON::useSchedule(bool on) {
+	on = on && sched_valid;
+	if (on == sched_on) return;
+	if (on) {
+		sched_base = PID::dump();
+		sched_on	= true;
+		applySchedule(temp_set);
+	} else {
+		sched_on	= false;
+		PID::retune(sched_base.Kp, sched_base.Ki, sched_base.Kd);
+	}
+}
+
+// Linear interpolation between the band reference temperatures, the outer bands keep their coefficients
+void IRON::applySchedule(uint16_t t) {
+	uint8_t i = 1;
+	while (i < PID_BANDS-1 && t > sched.temp[i]) ++i;
+	int32_t t0 = sched.temp[i-1];
+	int32_t t1 = sched.temp[i];
+	int32_t x  = constrain((int32_t)t, t0, t1);
+	int32_t kp = sched.Kp[i-1] + ((int32_t)sched.Kp[i] - sched.Kp[i-1]) * (x - t0) / (t1 - t0);
+	int32_t ki = sched.Ki[i-1] + ((int32_t)sched.Ki[i] - sched.Ki[i-1]) * (x - t0) / (t1 - t0);
+	int32_t kd = sched.Kd[i-1] + ((int32_t)sched.Kd[i] - sched.Kd[i-1]) * (x - t0) / (t1 - t0);
+	PID::retune(kp, ki, kd);								// Bumpless, see PIDQ::gains()
 }
 
-uint16_t IRON::power(int32_t t) {
-	t				= tempShortAverage(t);					// Prevent temperature deviation using short term history average
+/*
+ * The PID gets the Kalman estimate of the temperature: the oversampled reading keeps its extra bits in the filter.
+ * The power applied in this period is the input of the next prediction
+ */
+uint32_t IRON::power(int32_t t, uint8_t frac, uint8_t p_frac) {
+	if (est_load) {
+		est_load	= false;
+		est.model(est_model);
+	}
+	t				= est.update(t, frac);
+	if (t < 0) t = 0;										// The reading is not negative, the estimate can be near ambient
 	temp_curr		= t;
 	int32_t at 		= h_temp.average(temp_curr);
 	int32_t diff	= at - temp_curr;
@@ -172,39 +294,324 @@ uint16_t IRON::power(int32_t t) {
 		case POWER_OFF:
 			break;
 		case POWER_COOLING:
-			if (at < iron_cold)
+			if (t < iron_cold)
 				mode = POWER_OFF;
 			break;
 		case POWER_ON:
 			if (chill) {
 				if (t < (temp_set - 2)) {
 					chill = false;
-					resetPID();
+					reenter();
 				} else {
 					break;
 				}
 			}
-			p = PID::reqPower(temp_set, t);
-			p = constrain(p, 0, max_power);
+			if (heat == HEAT_FULL && heatUp(t)) {
+				p = (int32_t)pid_limit << p_frac;
+				break;
+			}
+			p = PID::reqPower(temp_set, t, p_frac);
+			p += loadPulse(t, p >> p_frac) << p_frac;
+			p = constrain(p, 0, (int32_t)pid_limit << p_frac);
+			if (heat == HEAT_LAND) heatLand(t);
 			break;
 		case POWER_FIXED:
-			p = fix_power;
+			p = fix_power << p_frac;
 			break;
 		case POWER_PID_TUNE:
-			p = PIDTUNE::run(t);
+			p = PIDTUNE::run(t) << p_frac;
 			break;
 		default:
 			break;
 	}
 
-	int32_t	ap		= h_power.average(p);
-	diff 			= ap - p;
+	int32_t pi		= p;									// The statistics are built on the integer power
+	if (p_frac)
+		pi = (p + (1 << (p_frac-1))) >> p_frac;
+	int32_t	ap		= h_power.average(pi);
+	diff 			= ap - pi;
 	d_power.update(diff*diff);
+	if (track_on && mode == POWER_ON)
+		trackSample(t, pi);
+	est.predict(pi);
 	return p;
 }
 
+void IRON::trackSample(int32_t t, int32_t p) {
+	uint32_t now = HAL_GetTick();
+	if (track_start) {
+		track_start	= false;
+		track_temp	= 0;
+		track_power	= 0;
+		track_count	= 0;
+		track_sat	= false;
+		track_begin	= now;
+	}
+	track_temp	+= t;
+	track_power	+= p;
+	++track_count;
+	if (p <= 0 || p >= pid_limit) track_sat = true;
+	if (now - track_begin < track_period) return;
+	IRON_SAMPLE s;
+	s.saturated	= track_sat;
+	s.temp		= (track_temp  + track_count/2) / track_count;
+	s.power		= (track_power + track_count/2) / track_count;
+	track_ring.push(s);										// If the main loop is late, the sample is lost, see trackUpdate()
+	track_temp	= 0;
+	track_power	= 0;
+	track_count	= 0;
+	track_sat	= false;
+	track_begin	= now;
+}
+
+// The heat-up runs in the working mode only, the other modes keep their own power. See heatUp()
+void IRON::heatStart(int32_t from) {
+	if (temp_set > temp_curr + heat_min) {
+		if (heat != HEAT_FULL) heat_from = from;
+		heat = HEAT_FULL;
+	}
+	else if (heat == HEAT_FULL)
+		heat = HEAT_OFF;
+}
+
+/*
+ * The time optimal heat-up: the full power is applied till the temperature predicted by the heating slope and the thermal lag
+ * of the tip reaches the preset one, then the PID starts with the integral term loaded by the holding power, so it does not
+ * have to wind up while the temperature lands. The lag is the time the temperature keeps on moving by the slope after the cutoff:
+ *    landing = t + slope * lag
+ * The thermocouple of T12 tip is on the heater, it leads the tip body while heating, so the lag is usually negative:
+ * the power is cut above the preset temperature and the reading falls to it when the heat spreads into the tip.
+ * The lag of the tip is measured by every heat-up, see heatLand()
+ * The tip switched on again before it has cooled down keeps the body warm, the reading does not fall that much after the cutoff.
+ * The lag is scaled by the part of the heat-up from the ambient (zero internal temperature) the warm tip has to rise
+ */
+bool IRON::heatUp(int32_t t) {
+	int32_t slope	= est.rate();
+	int32_t lag		= heat_lag;
+	if (heat_from > 0 && heat_from < temp_set)
+		lag = (int32_t)heat_lag * ((int32_t)temp_set - heat_from) / temp_set;
+	int32_t land	= t + slope * lag / 1000;
+	if (land < temp_set && t < temp_set + heat_over) return true;
+	heat		= HEAT_LAND;
+	heat_temp	= t;
+	heat_slope	= slope;
+	heat_cut	= HAL_GetTick();
+	heat_still	= heat_cut;
+	PID::preload(reentryPower());
+	return false;
+}
+
+/*
+ * The temperature has landed when its rate is less than 1/16 of the heating slope for heat_settle ms,
+ * the peak of the reading right after the cutoff is passed quickly. The measured lag is sent to the main loop.
+ * The lag of the warm tip is not the lag of the tip, it is not learned
+ */
+void IRON::heatLand(int32_t t) {
+	uint32_t now = HAL_GetTick();
+	if (abs(est.rate()) > heat_slope / 16) heat_still = now;
+	if (now - heat_cut > heat_timeout) {					// The IRON is in use, the lag is not measured
+		heat = HEAT_OFF;
+		return;
+	}
+	if (now - heat_still < heat_settle) return;
+	heat = HEAT_OFF;
+	if (heat_slope < heat_slope_min || heat_from > 0) return;
+	int32_t lag	= (t - heat_temp) * 1000 / heat_slope;
+	heat_result	= constrain(lag, -INT8_MAX * 20, INT8_MAX * 20);	// See TIP::lag
+	heat_done	= true;
+}
+
+int32_t IRON::holdEstimate(void) {
+	int32_t hold = PID::forward();
+	if (hold > 0) return hold;
+	PIDmodel m = est_model.isValid()?est_model:PIDmodel::typical();
+	return (int32_t)temp_set * 256 / m.gain;
+}
+
+bool IRON::isKeeping(void) {
+	if (mode != POWER_ON || chill || heat != HEAT_OFF) return false;
+	int32_t at = h_temp.read();
+	return abs(at - (int32_t)temp_set) <= keep_band;
+}
+
+int32_t IRON::reentryPower(void) {
+	if (hold_power > 0) return constrain(hold_power, 0, (int32_t)pid_limit);
+	return constrain(holdEstimate(), 0, (int32_t)pid_limit);
+}
+
+// The average power starts by the re-entry power too, so isKeeping() can rely on it once the temperature is kept
+void IRON::reenter(void) {
+	int32_t p = reentryPower();
+	PID::preload(p);
+	h_power.preset(p);
+	load_quiet	= HAL_GetTick();
+}
+
+/*
+ * The solder load detector. The Kalman filter explains the temperature by the power applied, the drift takes the rest,
+ * see KALMAN::loss(). When the tip touches a big pad, the temperature falls faster than the model predicts, so the loss
+ * grows at once, long before the error of the PID builds up through the temperature. The loss is applied as the feed-forward
+ * power while it is over the half of the threshold, then the PID takes the pulse into the integral term (bumpless).
+ * The event is logged when the temperature returns into the band. The temperature above the preset one is not the load:
+ * the fast heater node falls faster than the model when the power is reduced. The slow tip body takes the heat after
+ * the heat-up or the setpoint change the same way, so the detector is armed when the loss stays low for a while
+ */
+int32_t IRON::loadPulse(int32_t t, int32_t p) {
+	int32_t		loss	= est.loss();
+	uint32_t	now		= HAL_GetTick();
+	int32_t		drop	= (int32_t)temp_set - t;
+	if (heat != HEAT_OFF) {									// The heat-up is landing
+		load_quiet = now;
+		return 0;
+	}
+	if (load_phase == LOAD_OFF) {
+		bool armed = (now - load_quiet >= load_arm);
+		if (abs(loss) >= load_min) load_quiet = now;
+		if (!armed || loss < load_min || drop < 0) return 0;
+		load_phase			= LOAD_PULSE;
+		load_start			= now;
+		load_fade			= 0;
+		load_exit			= 0;
+		load_event.depth	= 0;
+		load_event.duration	= 0;
+		load_event.recovery	= 0;
+		load_event.peak		= 0;
+	}
+	if (drop > load_event.depth) load_event.depth = drop;
+	if (load_phase == LOAD_PULSE) {
+		if (drop >= 0 && loss >= load_min / 2) {
+			load_exit = 0;
+			load_fade = constrain(loss, 0, (int32_t)pid_limit);
+			if (load_fade > load_event.peak) load_event.peak = load_fade;
+			return load_fade;
+		}
+		if (++load_exit < load_confirm)						// A single corrupted reading restarts the estimator, keep the pulse
+			return load_fade;
+		load_phase			= LOAD_RECOVER;
+		load_event.duration	= now - load_start;
+		if (drop >= 0) {									// The load is less, the PID keeps the rest
+			PID::transfer(p + load_fade);
+			load_fade		= 0;
+		} else {											// The load is gone, the drift of the estimator is late to follow it
+			est.resetDrift();
+		}
+	}
+	if (load_fade) {										// The heater node falls faster than the model, so the pulse fades out
+		load_fade	= (load_fade * 15) >> 4;
+		return load_fade;
+	}
+	if (loss >= load_min && drop >= 0) {					// The next touch before the temperature has recovered
+		load_phase	= LOAD_PULSE;
+		load_exit	= 0;
+		return 0;
+	}
+	if (abs(drop) > load_band) {
+		if (now - load_start > load_timeout) load_phase = LOAD_OFF;
+		return 0;
+	}
+	load_phase			= LOAD_OFF;
+	load_event.recovery	= now - load_start;
+	load_ring.push(load_event);
+	return 0;
+}
+
+void IRON::loadUpdate(void) {
+	IRON_LOAD e;
+	const uint8_t len = sizeof(load_log) / sizeof(IRON_LOAD);
+	while (load_ring.pop(&e)) {
+		load_log[load_head]	= e;
+		load_head			= (load_head + 1) % len;
+		if (load_count < len) ++load_count;
+	}
+}
+
+IRON_LOAD IRON::loadEvent(uint8_t i) {
+	const uint8_t len = sizeof(load_log) / sizeof(IRON_LOAD);
+	IRON_LOAD e = {0};
+	if (i >= load_count) return e;
+	return load_log[(load_head + len - 1 - i) % len];
+}
+
+void IRON::heatLag(int16_t lag) {
+	heat_lag = lag;
+	if (lag == 0) heat_lag = heat_lag_def;
+}
+
+bool IRON::heatLearned(int16_t *lag) {
+	if (!heat_done) return false;
+	*lag		= heat_result;
+	heat_done	= false;
+	return true;
+}
+
+// The main loop changes the model, so it is passed to the estimator in the bottom half
+void IRON::trackInit(const PIDmodel &prior) {
+	track.init(prior, track_period);
+	est_load	= false;
+	est_model	= prior;
+	est_load	= true;
+}
+
+/*
+ * The working mode starts the online identification of the IRON model, the other modes pause it (see switchPower()).
+ * The history of the estimator is cleared on start, the model is kept. The samples where the PID power reached its limits
+ * are skipped: the heat-up at full power is dominated by the fast heater node and drags the first order model away
+ */
+void IRON::trackModel(bool on) {
+	track_on = false;
+	if (on) {
+		track_ring.clear();
+		track.restart();
+		track_start	= true;
+		track_on	= true;
+	}
+}
+
+// The samples are consecutive, so the lost one breaks the history of the estimator
+void IRON::trackUpdate(void) {
+	IRON_SAMPLE s;
+	while (track_ring.pop(&s)) {
+		if (s.saturated)
+			track.restart();
+		else
+			track.update(s.temp, s.power);
+	}
+	uint32_t lost = track_ring.overrun();
+	if (lost != track_lost) {
+		track_lost = lost;
+		track.restart();
+	}
+}
+
+bool IRON::adaptPID(const PIDmodel &m, const PIDparam &base) {
+	if (sched_on) return false;
+	return PID::adapt(m, base);
+}
+
+void IRON::controlPeriod(uint32_t us) {
+	if (us == 0) return;
+	est.controlPeriod(us);
+	PID::controlPeriod(us);
+	uint8_t l = empLength(ec, us);
+	h_power.rescale(l);
+	h_temp.rescale(l);
+	d_power.rescale(l);
+	d_temp.rescale(l);
+}
+
+/*
+ * The power the hardware can apply is less than max_power because of the measurement window.
+ * The PID engine unwinds the integral term against this limit, see PIDQ
+ */
+void IRON::powerLimit(uint16_t max) {
+	if (max > max_power) max = max_power;
+	if (max == pid_limit) return;
+	pid_limit = max;
+	PID::powerLimits(0, pid_limit);
+}
+
 void IRON::reset(void) {
-	resetShortTemp();
+	est.reset();
 	h_power.reset();
 	h_temp.reset();
 	d_power.reset();
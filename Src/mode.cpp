@@ -36,6 +36,7 @@ void MSTBY_IRON::init(void) {
 	int16_t  	ambient		= pIron->ambientTemp();
 	uint16_t 	temp_setH	= pCFG->tempPresetHuman();
 	uint16_t 	temp_set	= pCFG->humanToTemp(temp_setH, ambient);
+	pIron->useSchedule(!pCFG->isTipPID());					// The PID parameters tuned for the tip are better than the common schedule
 	pIron->setTemp(temp_set);
 	pD->msgOFF();
 	pD->tip(pCFG->tipName());
@@ -128,6 +129,7 @@ void MWORK_IRON::init(void) {
 	int16_t  ambient	= pIron->ambientTemp();
 	uint16_t tempH  	= pCFG->tempPresetHuman();
 	preset_temp			= pCFG->humanToTemp(tempH, ambient);
+	pIron->useSchedule(!pCFG->isTipPID());
 	uint16_t t_min		= pCFG->tempMinC();
 	uint16_t t_max		= pCFG->tempMaxC();
 	if (!celsius) {											// The preset temperature saved in selected units
@@ -135,18 +137,28 @@ void MWORK_IRON::init(void) {
 		t_max	= celsiusToFahrenheit(t_max);
 	}
 	pEnc->reset(tempH, t_min, t_max, 1, 5, false);
-	pIron->setTemp(preset_temp);
+	pIron->setTemp(preset_temp, pCFG->holdPower(preset_temp, ambient));
 	pD->mainInit();
 	pD->msgON();
 	pD->tip(pCFG->tipName());
 	idle_pwr.reset();										// Initialize the history for power in idle state
+	hold_loops			= 0;
+	hold_sum			= 0;
+	hold_learned		= false;
 	auto_off_notified 	= false;
 	ready 				= false;
 	lowpower_mode		= false;
 	time_to_return		= 0;
 	old_temp_set 		= 0;
 	update_screen		= 0;
+	model_saved			= false;
+	ready_start			= HAL_GetTick();
+	ready_time			= 0;
+	if (pCFG->isAdaptPID())									// Start by the model of the tip identified earlier
+		pIron->adaptPID(pCFG->tipModel(), pCFG->pidParams());
+	pIron->heatLag(pCFG->tipLag());
 	pIron->switchPower(true);
+	pIron->trackModel(true);
 	SCRSAVER::init(pCFG->getScrTo());
 }
 
@@ -160,9 +172,67 @@ void MWORK_IRON::adjustPresetTemp(void) {
 	uint16_t temp  		= pCFG->humanToTemp(tempH, ambient); // Expected temperature of IRON in internal units
 	if (temp != presetTemp) {								// The ambient temperature have changed, we need to adjust preset temperature
 		pIron->adjust(temp);
+		pIron->holdPower(pCFG->holdPower(temp, ambient));
 	}
 }
 
+/*
+ * Learn the holding power model of the tip: the IRON keeps the preset temperature and nobody uses it (the power is stable).
+ * The power is averaged for hold_learn_loops screen updates, the model is saved once per preset temperature
+ */
+void MWORK_IRON::learnHoldPower(int temp, int temp_set, uint32_t td, uint32_t pd, uint16_t ap, int16_t ambient) {
+	CFG*	pCFG	= &pCore->cfg;
+	IRON*	pIron	= &pCore->iron;
+
+	if (hold_learned) return;
+	if (abs(temp_set - temp) > 4 || td > 200 || pd > 25 || ap == 0) {
+		hold_loops	= 0;
+		hold_sum	= 0;
+		return;
+	}
+	hold_sum += ap;
+	if (++hold_loops < hold_learn_loops) return;
+	uint16_t power	= hold_sum / hold_loops;
+	uint8_t  model	= pCFG->holdModel(temp_set, ambient, power);
+	hold_learned	= true;
+	if (model == 0) return;									// The temperature is too low to learn
+	pCFG->saveTipHold(model);
+	pIron->holdPower(pCFG->holdPower(temp_set, ambient));
+}
+
+/*
+ * Follow the IRON model identified online (see RLS) when it is confident: retune the PID if the adaptive PID is enabled
+ * and save the model of the tip once per session if it differs from the saved one more than 1/8
+ */
+void MWORK_IRON::trackModel(void) {
+	CFG*	pCFG	= &pCore->cfg;
+	IRON*	pIron	= &pCore->iron;
+
+	if (pIron->trackedConfidence() < track_confidence) return;
+	PIDmodel m = pIron->trackedModel();
+	if (!m.isValid()) return;
+	if (pCFG->isAdaptPID())
+		pIron->adaptPID(m, pCFG->pidParams());
+	if (model_saved) return;
+	model_saved		= true;
+	PIDmodel s		= pCFG->tipModel();
+	if (s.isValid() && abs(m.gain - s.gain) <= s.gain / 8 && abs(m.tau - s.tau) <= s.tau / 8) return;
+	pCFG->saveTipModel(m);
+}
+
+// Average the thermal lag measured by the heat-up with the saved one, see IRON::heatUp()
+void MWORK_IRON::heatLag(void) {
+	CFG*	pCFG	= &pCore->cfg;
+	IRON*	pIron	= &pCore->iron;
+
+	int16_t lag = 0;
+	if (!pIron->heatLearned(&lag)) return;
+	int16_t saved = pCFG->tipLag();
+	if (saved) lag = (saved + lag) / 2;
+	pCFG->saveTipLag(lag);
+	pIron->heatLag(pCFG->tipLag());
+}
+
 void MWORK_IRON::hwTimeout(uint16_t low_temp, bool tilt_active) {
 	DSPL*	pD		= &pCore->dspl;
 	CFG*	pCFG	= &pCore->cfg;
@@ -172,10 +242,11 @@ void MWORK_IRON::hwTimeout(uint16_t low_temp, bool tilt_active) {
 	if (tilt_active) {										// If the IRON is used, Reset standby time
 		lowpower_time = now_ms + pCFG->getLowTO() * 1000;	// Convert timeout to milliseconds
 		if (lowpower_mode) {								// If the IRON is in low power mode, return to main working mode
-			pIron->setTemp(preset_temp);
+			pIron->setTemp(preset_temp, pCFG->holdPower(preset_temp, pIron->ambientTemp()));
 			lowpower_time	= 0;
 			lowpower_mode	= false;
 			ready 			= false;
+			ready_start		= now_ms;
 			time_to_return	= 0;							// Disable to return to the POWER OFF mode
 			pCore->buzz.shortBeep();
 			pD->msgON();
@@ -187,7 +258,7 @@ void MWORK_IRON::hwTimeout(uint16_t low_temp, bool tilt_active) {
 				int16_t  ambient	= pIron->ambientTemp();
 				uint16_t temp_low	= pCFG->getLowTemp();
 				uint16_t temp 		= pCFG->lowPowerTemp(temp_low, ambient);
-				pIron->setTemp(temp);
+				pIron->setTemp(temp, pCFG->holdPower(temp, ambient));
 				time_to_return 		= HAL_GetTick() + pCFG->getOffTimeout() * 60000;
 				auto_off_notified 	= false;
 				lowpower_mode		= true;
@@ -257,18 +328,25 @@ MODE* MWORK_IRON::loop(void) {
 	if (temp_setH != old_temp_set) {						// Encoder rotated, new preset temp entered
 	   	old_temp_set 		= temp_setH;
 		ready 				= false;
+		ready_start			= HAL_GetTick();
 		time_to_return 		= 0;
 		auto_off_notified 	= false;
 		lowpower_mode		= false;
 		pD->msgON();
 		uint16_t temp = pCFG->humanToTemp(temp_setH, ambient); // Translate human readable temperature into internal value
-		pIron->setTemp(temp);
+		pIron->setTemp(temp, pCFG->holdPower(temp, ambient));
 		pCFG->savePresetTempHuman(temp_setH);
 		idle_pwr.reset();									// Initialize the history for power in idle state
+		hold_loops			= 0;
+		hold_sum			= 0;
+		hold_learned		= false;
 		update_screen = 0;
 		scr_saver_reset 	= true;
 	}
 	if (scr_saver_reset) SCRSAVER::reset();
+	pIron->trackUpdate();
+	heatLag();
+	pIron->loadUpdate();
 
 	if (HAL_GetTick() < update_screen) 		return this;
     update_screen = HAL_GetTick() + period;
@@ -294,6 +372,7 @@ MODE* MWORK_IRON::loop(void) {
 	    if (!ready) {
 	    	ready = true;
 	    	ready_clear	= HAL_GetTick() + 2000;
+	    	ready_time	= HAL_GetTick() - ready_start;
 	    	pD->msgReady();
 	    	pCore->buzz.shortBeep();
 	    	pD->mainShow(temp_setH, tempH, ambient, p, pCFG->isCelsius(), pCFG->isTipCalibrated(), tilt_active);
@@ -321,12 +400,23 @@ MODE* MWORK_IRON::loop(void) {
 			}
 		}
 	}
-	if (!lowpower_mode)
+	if (!lowpower_mode) {
 		adjustPresetTemp();
+		if (ready) {
+			learnHoldPower(temp, temp_set, td, pd, ap, ambient);
+			trackModel();
+		}
+	}
 
 	if (ready && ready_clear && HAL_GetTick() >= ready_clear) {
-		ready_clear = 0;
-		pD->msgON();
+		if (ready_time) {									// Show the time to reach the preset temperature after 'Ready' message
+			pD->readyTime(ready_time);
+			ready_time	= 0;
+			ready_clear	= HAL_GetTick() + 3000;
+		} else {
+			ready_clear = 0;
+			pD->msgON();
+		}
 	}
 
 	if (scrSaver()) {
@@ -353,7 +443,8 @@ void MBOOST::init(void) {
 		delta = (delta * 9 + 3) / 5;
 	tempH			   += delta;
 	temp_set 			= pCFG->humanToTemp(tempH, ambient);
-	pIron->setTemp(temp_set);
+	pIron->useSchedule(!pCFG->isTipPID());
+	pIron->setTemp(temp_set, pCFG->holdPower(temp_set, ambient));
 	pIron->switchPower(true);
 	time_to_return		= HAL_GetTick() + 30000;
 	pEnc->reset(0, 0, 1, 1, 1, false);
@@ -434,6 +525,11 @@ MODE* MSLCT::loop(void) {
 		}
 		uint8_t tip_index = tip_list[index].tip_index;
 		pCFG->changeTip(tip_index);
+		pIron->useSchedule(false);
+		PIDparam pp = pCFG->pidParams();					// The new tip can have its own PID parameters
+		pIron->load(pp);
+		pIron->model(pCFG->pidModel(), pCFG->isTipSmith());
+		pIron->trackInit(pCFG->tipModel());
 		return mode_return;
 	}
 
@@ -552,6 +648,7 @@ void MMENU::init(void) {
 	buzzer		= pCFG->isBuzzerEnabled();
 	celsius		= pCFG->isCelsius();
 	reed		= pCFG->isReedType();
+	adapt		= pCFG->isAdaptPID();
 	scr_saver	= pCFG->getScrTo();
 	set_param	= 0;
 	if (!pCFG->isTipCalibrated())
@@ -607,7 +704,7 @@ MODE* MMENU::loop(void) {
 		if (button > 0) {										// The button was pressed
 			switch (item) {
 				case 0:											// Boost parameters
-					pCFG->setup(off_timeout, buzzer, celsius, reed, low_temp, low_to, scr_saver);
+					pCFG->setup(off_timeout, buzzer, celsius, reed, low_temp, low_to, scr_saver, adapt);
 					return mode_menu_boost;
 				case 1:											// units C/F
 					celsius	= !celsius;
@@ -645,7 +742,7 @@ MODE* MMENU::loop(void) {
 					}
 					break;
 				case 8:											// save
-					pCFG->setup(off_timeout, buzzer, celsius, reed, low_temp, low_to, scr_saver);
+					pCFG->setup(off_timeout, buzzer, celsius, reed, low_temp, low_to, scr_saver, adapt);
 					pCFG->saveConfig();
 					pCore->buzz.activate(buzzer);
 					mode_menu_item = 0;
@@ -665,7 +762,10 @@ MODE* MMENU::loop(void) {
 					return mode_return;
 				case 14:										// Tune PID
 					return mode_tune_pid;
-				case 15:										// About dialog
+				case 15:										// Adaptive PID ON/OFF
+					adapt	= !adapt;
+					break;
+				case 16:										// About dialog
 					mode_menu_item = 0;
 					return mode_about;
 				default:										// cancel
@@ -718,6 +818,12 @@ MODE* MMENU::loop(void) {
 			else
 				sprintf(item_value, "TILT");
 			break;
+		case 15:												// Adaptive PID
+			if (adapt)
+				sprintf(item_value, "ON");
+			else
+				sprintf(item_value, "OFF");
+			break;
 		case 4:													// auto off timeout
 			if (off_timeout) {
 				sprintf(item_value, "%2d min", off_timeout);
@@ -759,13 +865,13 @@ MODE* MMENU::loop(void) {
 }
 
 //---------------------- Calibrate tip menu --------------------------------------
-MCALMENU::MCALMENU(HW* pCore, MODE* cal_auto, MODE* cal_manual) : MODE(pCore) {
-	mode_calibrate_tip = cal_auto; mode_calibrate_tip_manual = cal_manual;
+MCALMENU::MCALMENU(HW* pCore, MODE* cal_auto, MODE* cal_manual, MODE* cal_settle) : MODE(pCore) {
+	mode_calibrate_tip = cal_auto; mode_calibrate_tip_manual = cal_manual; mode_calibrate_settle = cal_settle;
 }
 
 void MCALMENU::init(void) {
-	pCore->encoder.reset(0, 0, 3, 1, 1, true);
-	old_item		= 4;
+	pCore->encoder.reset(0, 0, 4, 1, 1, true);
+	old_item		= 5;
 	update_screen	= 0;
 }
 
@@ -797,7 +903,9 @@ MODE* MCALMENU::loop(void) {
 				return mode_calibrate_tip;
 			case 1:												// Calibrate tip manually
 				return mode_calibrate_tip_manual;
-			case 2:												// Initialize tip calibration data
+			case 2:												// Measure the amplifier settle time
+				return mode_calibrate_settle;
+			case 3:												// Initialize tip calibration data
 				pCFG->resetTipCalibration();
 				return mode_return;
 			default:											// exit
@@ -827,6 +935,7 @@ void MCALIB::init(void) {
 		min_t 	=  122;
 		max_t 	= 1111;
 	}
+	pIron->useSchedule(false);
 	PIDparam pp = pCFG->pidParamsSmooth();						// Load PID parameters to stabilize the temperature of unknown tip
 	pIron->PID::load(pp);
 	pEnc->reset(0, min_t, max_t, 1, 5, false);
@@ -1065,6 +1174,7 @@ void MCALIB_MANUAL::init(void) {
 	temp_setready_ms	= 0;
 	old_encoder			= 4;
 	update_screen		= 0;
+	pCore->iron.useSchedule(false);
 	PIDparam pp 		= pCFG->pidParamsSmooth();
 	pCore->iron.PID::load(pp);
 }
@@ -1195,6 +1305,59 @@ MODE* MCALIB_MANUAL::loop(void) {
 	return	this;
 }
 
+//---------------------- The amplifier settle time calibration mode -------------
+/*
+ * The thermocouple amplifier is saturated while the IRON is powered. The measurement window starts
+ * after the blanking window, the time the amplifier needs to settle after the power off.
+ * The shorter blanking window, the higher the maximum IRON power. See adcSettleStart() in core.cpp
+ */
+void MSETTLE::init(void) {
+	IRON*	pIron	= &pCore->iron;
+	pCore->encoder.reset(0, 0, 1, 1, 1, false);
+	pIron->switchPower(false);
+	started			= pIron->isIronConnected() && adcSettleStart();
+	update_screen	= 0;
+}
+
+MODE* MSETTLE::loop(void) {
+	DSPL*	pD		= &pCore->dspl;
+	CFG*	pCFG	= &pCore->cfg;
+
+	uint8_t button		= pCore->encoder.buttonStatus();
+	uint8_t progress	= adcSettleProgress();
+	uint8_t ticks		= adcSettleResult();
+	if (button == 2) {											// Long press: discard the result
+		adcSettleStop();
+		return mode_lpress;
+	} else if (button == 1) {
+		if (started && progress < 100) {						// Cancel the measurement
+			adcSettleStop();
+		} else if (started && ticks) {							// Save the result
+			pCFG->saveSettle(ticks);
+			pCFG->saveConfig();
+			adcBlanking(ticks);
+		}
+		return mode_return;
+	}
+
+	if (HAL_GetTick() < update_screen) return this;
+	update_screen = HAL_GetTick() + 500;
+
+	char item[12], value[8];
+	if (!started) {
+		pD->menuItemShow("Settle time", "no IRON", 0, false);
+	} else if (progress < 100) {
+		sprintf(value, "%3d%%", progress);
+		pD->menuItemShow("Settle time", "measuring", value, false);
+	} else if (ticks) {
+		sprintf(item, "%d us", (ticks * 125 + 6) / 12);		// TIM2 tick is 750/72 us
+		pD->menuItemShow("Settle time", item, "save", false);
+	} else {
+		pD->menuItemShow("Settle time", "failed", 0, false);
+	}
+	return this;
+}
+
 //---------------------- The Boost setup menu mode -------------------------------
 void MMBST::init(void) {
 	CFG*	pCFG	= &pCore->cfg;
@@ -1370,13 +1533,15 @@ void MTPID::init(void) {
 
 	pD->pidInit();
 	pD->pidSetLowerAxisLabel("Dp");
-	pEnc->reset(0, 0, 2, 1, 1, true);							// Select the coefficient to be modified
+	pEnc->reset(0, 0, 4, 1, 1, true);							// Select the coefficient to be modified: Kp, Ki, Kd, b, c
+	pCore->iron.useSchedule(false);								// Tune the base PID parameters
+	pCore->iron.load(pCore->cfg.pidParams());					// Not the adapted ones, see MWORK_IRON::trackModel()
 	pCore->iron.setTemp(1200);									// Use 'middle' temperature
 	data_update 		= 0;
 	data_index 			= 0;
 	modify				= false;
 	on					= false;
-	old_index			= 3;
+	old_index			= 5;
 	temp_setready_ms	= 0;
 	update_screen 		= 0;
 }
@@ -1412,7 +1577,7 @@ MODE* MTPID::loop(void) {
 		update_screen = HAL_GetTick() + 100;
 		if (button == 1) {									// Short button press: select another PID coefficient
 			modify = false;
-			pEnc->reset(data_index, 0, 2, 1, 1, true);
+			pEnc->reset(data_index, 0, 4, 1, 1, true);
 			return this;									// Restart the procedure
 		} else if (button == 2) {							// Long button press: toggle the power
 			on = !on;
@@ -1443,19 +1608,23 @@ MODE* MTPID::loop(void) {
 			// Prepare to change the coefficient [index]
 			uint16_t k = 0;
 			k = pIron->changePID(index+1, -1);				// Read the PID coefficient from the IRON or Hot Air Gun
-			pEnc->reset(k, 0, 20000, 1, 10, false);
+			if (index < 3)
+				pEnc->reset(k, 0, 20000, 1, 10, false);
+			else											// The setpoint weight, tenths
+				pEnc->reset(k, 0, PIDparam::weight_one, 1, 1, false);
 			return this;									// Restart the procedure
 		} else if (button == 2) {							// Long button press: save the parameters and return to menu
 			PIDparam pp = pIron->dump();
-			pCFG->savePID(pp);
+			if (!pCFG->isTipPID() || !pCFG->saveTipPID(pp))	// The tip tuned by MAUTOPID keeps its own parameters
+				pCFG->savePID(pp);
 			return mode_lpress;
 		}
 
-		uint16_t pid_k[3];
-		for (uint8_t i = 0; i < 3; ++i) {
+		uint16_t pid_k[5];
+		for (uint8_t i = 0; i < 5; ++i) {
 			pid_k[i] = 	pIron->changePID(i+1, -1);
 		}
-		pD->pidShowMenu(pid_k, data_index);
+		pD->pidShowMenu(pid_k, data_index, pIron->trackedConfidence());
 	}
 	return this;
 }
@@ -1466,9 +1635,13 @@ void MAUTOPID::init(void) {
 	IRON*	pIron	= &pCore->iron;
 	CFG*	pCFG	= &pCore->cfg;
 
+	pIron->useSchedule(false);
 	PIDparam pp = pCFG->pidParamsSmooth();						// Load PID parameters to stabilize the temperature of unknown tip
 	pIron->PID::load(pp);
+	pCore->encoder.reset(0, 0, 1, 1, 1, true);					// Select the tuning: all the tips (gain schedule) or the current tip only
+	tip_only		= false;
 	pD->pidInit();
+	pD->autoPidInfo("All tips");
 	base_temp 		= pIron->presetTemp();
 	data_update 	= 0;
 	data_period		= 250;
@@ -1481,9 +1654,14 @@ MODE* MAUTOPID::loop(void) {
 	IRON*	pIron	= &pCore->iron;
 	RENC*	pEnc	= &pCore->encoder;
 
-	//uint16_t  index 	= pEnc->read();
+	uint16_t index 		= pEnc->read();
 	uint8_t  button		= pEnc->buttonStatus();
 
+	if (mode == TUNE_OFF && tip_only != (index == 1)) {
+		tip_only = (index == 1);
+		pD->autoPidInfo(tip_only?"This tip":"All tips");
+	}
+
 	if (!pIron->isIronConnected()) return 0;
 	if(button)
 		update_screen = 0;
@@ -1501,12 +1679,17 @@ MODE* MAUTOPID::loop(void) {
 	if (button == 1) {											// Short button press: switch on/off the power
 		data_period	= 250;
 		if (mode == TUNE_OFF) {
-			mode = TUNE_HEATING;
-			base_temp 		= pIron->presetTemp();
-			pD->pidInit();										// Reset display graph history
-			pD->pidSetLowerAxisLabel("Dp");
-			pD->autoPidInfo("To preset");
-			pIron->switchPower(true);							// First, heat the IROn to the preset temperature
+			if (tip_only) {
+				mode = TUNE_HEATING;
+				base_temp 		= pIron->presetTemp();
+				pD->pidInit();									// Reset display graph history
+				pD->pidSetLowerAxisLabel("Dp");
+				pD->autoPidInfo("To preset");
+				pIron->switchPower(true);						// First, heat the IROn to the preset temperature
+			} else {
+				band = 0;
+				bandStart();									// First, heat the IROn to the reference temperature of the first band
+			}
 		} else {												// Long press
 			if ((mode == TUNE_RELAY) && (tune_loops > 8) && updatePID()) {
 				if (mode_spress) return mode_spress;
@@ -1576,6 +1759,10 @@ MODE* MAUTOPID::loop(void) {
 					data_period	= constrain(tune_period/40, 50, 2000);	// Try to display two periods on the screen
 				} else {
 					if ((tune_loops >= 32) && updatePID()) {
+						if (!tip_only && !bandTuned()) {		// Tune the next band
+							bandStart();
+							break;
+						}
 						pIron->switchPower(false);
 						mode = TUNE_OFF;
 						if (mode_spress) return mode_spress;
@@ -1596,6 +1783,9 @@ MODE* MAUTOPID::loop(void) {
  * diff  = alpha^2 - epsilon^2, where
  * alpha	- the amplitude of temperature oscillations
  * epsilon	- the temperature hysteresis
+ * When the current tip is tuned, the IRON model is identified by the same oscillations (see PID::identify()),
+ * the PID parameters are built by the model and saved in the tip record with the model, see CFG::saveTipPID().
+ * The Smith predictor is used if the dead time is not less than the time constant: otherwise the PID tuned by the model is tight enough.
  */
 bool MAUTOPID::updatePID(void) {
 	IRON*	pIron	= &pCore->iron;
@@ -1603,12 +1793,66 @@ bool MAUTOPID::updatePID(void) {
 	int32_t diff	= alpha*alpha - delta_temp*delta_temp;
 	if (diff > 0) {
 		pIron->newPIDparams(delta_power, diff, pIron->autoTunePeriod());
+		if (tip_only) {
+			PIDmodel m		= PID::identify(base_pwr, base_temp, delta_power, alpha, delta_temp, pIron->autoTunePeriod());
+			bool smith		= m.isValid() && m.dead >= m.tau;
+			pIron->modelPIDparams(m, smith);
+			PIDparam pp		= pIron->dump();
+			pCore->cfg.saveTipPID(pp, &m, smith);
+			pIron->trackInit(pCore->cfg.tipModel());		// The online identification starts by the relay model
+		}
 		pCore->buzz.shortBeep();
 		return true;
 	}
 	return false;
 }
 
+void MAUTOPID::bandStart(void) {
+	DSPL*	pD		= &pCore->dspl;
+	IRON*	pIron	= &pCore->iron;
+	CFG*	pCFG	= &pCore->cfg;
+
+	if (band > 0) {
+		PIDparam pp = pCFG->pidParamsSmooth();					// Stabilize the temperature of the next band
+		pIron->PID::load(pp);
+	}
+	uint16_t tempH		= band_temp[band];
+	if (!pCFG->isCelsius())
+		tempH = celsiusToFahrenheit(tempH);
+	base_temp 			= pCFG->humanToTemp(tempH, pIron->ambientTemp());
+	pIron->setTemp(base_temp);
+	mode 				= TUNE_HEATING;
+	data_period			= 250;
+	char msg[12];
+	sprintf(msg, "To band %d", band+1);
+	pD->pidInit();												// Reset display graph history
+	pD->pidSetLowerAxisLabel("Dp");
+	pD->autoPidInfo(msg);
+	pIron->switchPower(true);
+}
+
+/*
+ * The band is tuned when the relay method completes at the band reference temperature.
+ * The schedule is saved and activated when the last band is tuned, so a partially tuned schedule is never used.
+ * The coefficients of the middle band are left loaded to be reviewed in the PID tune mode.
+ */
+bool MAUTOPID::bandTuned(void) {
+	IRON*	pIron	= &pCore->iron;
+	CFG*	pCFG	= &pCore->cfg;
+
+	PIDparam pp 			= pIron->dump();
+	schedule.temp[band]		= pIron->presetTemp();
+	schedule.Kp[band]		= constrain(pp.Kp, 0, 0xFFFF);
+	schedule.Ki[band]		= constrain(pp.Ki, 0, 0xFFFF);
+	schedule.Kd[band]		= constrain(pp.Kd, 0, 0xFFFF);
+	if (++band < PID_BANDS) return false;
+	pCFG->saveSchedule(&schedule);
+	pIron->schedule(&schedule);
+	uint8_t m = PID_BANDS/2;
+	pIron->retune(schedule.Kp[m], schedule.Ki[m], schedule.Kd[m]);
+	return true;
+}
+
 //---------------------- The Fail mode: display error message --------------------
 void MFAIL::init(void) {
 	RENC*	pEnc	= &pCore->encoder;
@@ -1675,13 +1919,25 @@ MODE* MDEBUG::loop(void) {
 		pIron->fixPower(pwr);
 	}
 
-	if (pCore->encoder.buttonStatus() == 2) {					// The button was pressed for a long time
+	uint8_t button = pCore->encoder.buttonStatus();
+	if (button == 1) {											// Short press: switch between raw data, timing and load events
+		page			= (page + 1) % 3;
+		update_screen	= 0;
+	} else if (button == 2) {									// The button was pressed for a long time
 	   	return mode_lpress;
 	}
 
 	if (HAL_GetTick() < update_screen) return this;
 	update_screen = HAL_GetTick() + 500;
 
+	if (page == 1) {
+		pD->debugTiming(adcTiming());
+		return this;
+	} else if (page == 2) {
+		pD->debugLoad(pIron->loadEvent(0), pIron->loadEvents());
+		return this;
+	}
+
 	uint16_t data[5];
 	data[0]		= pIron->temp();
 	data[1] 	= pIron->ironCurrent();
@@ -9,49 +9,149 @@
 #include "tools.h"
 #include <math.h>
 
-PIDparam::PIDparam(int32_t Kp, int32_t Ki, int32_t Kd) {
+PIDparam::PIDparam(int32_t Kp, int32_t Ki, int32_t Kd, uint8_t b, uint8_t c) {
 	this->Kp	= Kp;
 	this->Ki	= Ki;
 	this->Kd	= Kd;
+	this->b		= b;
+	this->c		= c;
 }
 
 PIDparam::PIDparam(const PIDparam &p) {
 	Kp	= p.Kp;
 	Ki	= p.Ki;
 	Kd	= p.Kd;
+	b	= p.b;
+	c	= p.c;
 }
 
 void PID::load(const PIDparam &p) {
 	Kp	= p.Kp;
 	Ki	= p.Ki;
 	Kd	= p.Kd;
+	Kb	= constrain(p.b, 0, PIDparam::weight_one);
+	Kc	= constrain(p.c, 0, PIDparam::weight_one);
+	scale();
+}
+
+void PID::retune(int32_t Kp, int32_t Ki, int32_t Kd) {
+	if (Kp == this->Kp && Ki == this->Ki && Kd == this->Kd) return;
+	this->Kp	= Kp;
+	this->Ki	= Ki;
+	this->Kd	= Kd;
+	scale();
 }
 
 void PID::init(uint8_t denominator_p) {							// PID parameters are initialized from EEPROM by  call
 	Kp	= 10;
 	Ki	= 10;
 	Kd  = 0;
+	Kb	= PIDparam::weight_one;
+	Kc	= 0;
 	this->denominator_p = denominator_p;
+	powerLimits(0, 0x7FFF);
+	scale();
+}
+
+void PID::controlPeriod(uint32_t us) {
+	if (us == 0 || us == period_us) return;
+	period_us = us;
+	scale();
+	if (smith.isOn())
+		smith.model(fopdt, period_us);
+}
+
+void PID::scale(void) {
+	PID_LOCK lock;											// The main loop changes the gains on the fly
+	ki_t	= ((int64_t)Ki * period_us + ref_period/2) / ref_period;
+	kd_t	= ((int64_t)Kd * ref_period + period_us/2) / period_us;
+#ifndef PID_V1
+	engine.gains(Kp, ki_t, kd_t, denominator_p);
+	engine.weights(Kb, Kc);
+#endif
+}
+
+void PID::powerLimits(int32_t low, int32_t high) {
+	PID_LOCK lock;
+	pwr_low		= low;
+	pwr_high	= high;
+#ifndef PID_V1
+	engine.limits(low, high);
+#endif
+}
+
+void PID::feedForward(int32_t power, bool bumpless) {
+	PID_LOCK lock;
+	ff_power = power;
+#ifndef PID_V1
+	engine.feedForward(power, bumpless);
+#endif
 }
 
 void PID::resetPID(void) {
+	PID_LOCK lock;
 	temp_h0 		= 0;
 	temp_h1 		= 0;
 	power  			= 0;
 	i_summ 			= 0;
+	i_start			= 0;
+	smith.reset();
+#ifndef PID_V1
+	engine.reset();
+#endif
+}
+
+// The bumpless start by the expected power, see IRON::heatUp()
+void PID::preload(int32_t power) {
+	PID_LOCK lock;
+	resetPID();
+	i_start			= power - ff_power;
+#ifndef PID_V1
+	engine.preload(power);
+#endif
+}
+
+// The bumpless transfer to the new preset temperature, see IRON::setTemp()
+void PID::transfer(int32_t power) {
+	PID_LOCK lock;
+#ifndef PID_V1
+	engine.transfer(power);
+#else
+	if (temp_h0 == 0)										// The history is not ready yet, see control()
+		i_start		= power - ff_power;
+	else
+		this->power	= (power - ff_power) << denominator_p;
+#endif
+}
+
+void PID::model(const PIDmodel &m, bool predictor) {
+	PID_LOCK lock;
+	fopdt = m;
+	if (predictor) {
+		smith.model(fopdt, period_us);
+		smith.reset();
+	} else {
+		smith.model(PIDmodel(), period_us);
+	}
 }
 
 int32_t PID::changePID(uint8_t p, int32_t k) {
 	switch(p) {
     	case 1:
-    		if (k >= 0) Kp = k;
+    		if (k >= 0) { Kp = k; scale(); }
     		return Kp;
     	case 2:
-    		if (k >= 0) Ki = k;
+    		if (k >= 0) { Ki = k; scale(); }
     		return Ki;
     	case 3:
-    		if (k >= 0) Kd = k;
+    		if (k >= 0) { Kd = k; scale(); }
     		return Kd;
+    	case 4:
+    		if (k >= 0) { Kb = constrain(k, 0, PIDparam::weight_one); scale(); }
+    		return Kb;
+    	case 5:
+    		if (k >= 0) { Kc = constrain(k, 0, PIDparam::weight_one); scale(); }
+    		return Kc;
     	default:
     		break;
 	}
@@ -67,43 +167,347 @@ int32_t PID::changePID(uint8_t p, int32_t k) {
  * Kp = 0.6*Ku; Ti = 0.5*Pu; Td = 0.125*Pu;
  * Ki = Kp*T/Ti;
  * Kd = Kp*Td/T;
+ * T is the reference control period, the relay oscillation period is measured in ms, so it does not depend on the active one
  */
 void PID::newPIDparams(uint16_t delta_power, uint32_t diff, uint32_t period) {
-	uint32_t T = 50;										// Check IRON period, ms
+	const uint32_t T = ref_period;							// The control period of the coefficients, us
+	if (period == 0) return;
 	double Ku  = 4 * delta_power;
 	Ku /= M_PI * sqrt(diff);
 	uint32_t denominator = 1 << denominator_p;
 	Kp = round(Ku * 0.6 * denominator);						// Translate Kp to the numerator of implemented PID
-	Ki = (Kp * T * 2 + period/2) / period;
-	Kd = (Kp * period) >> 3;								// 1/8
-	Kd += T/2;
-	Kd /= T;
+	Ki = ((int64_t)Kp * T * 2 + period * 500) / (period * 1000);
+	Kd = ((int64_t)Kp * period * 125 + T/2) / T;			// Kp * (period/8) ms / T us
 	/*
 	 *  The algorithm gives very big values for Kd (about 39 -> 39*2048=79892)
 	 *  The big values of Kd gives us the big power dispersion
 	 *  That is why it is better to limit the Kd value.
 	 */
 	Kd = constrain(Kd, 0, 10000);
+	scale();
 }
 
-int32_t PID::reqPower(int16_t temp_set, int16_t temp_curr) {
+/*
+ * The first order plus dead time model by the relay method, see PIDTUNE. The relay with hysteresis keeps the oscillations where
+ *    G(jw) = -PI/(4*d) * (sqrt(alpha^2 - epsilon^2) + j*epsilon), w = 2*PI/Pu
+ * d - the relay power (delta_power), alpha - the amplitude of the temperature oscillations, epsilon - the relay hysteresis, Pu - the period.
+ * The static gain is the base temperature to the base power ratio, the internal temperature is zero at ambient temperature.
+ * For G(jw) = gain * exp(-jw*dead) / (1 + jw*tau):
+ *    tau  = sqrt((4*d*gain / (PI*alpha))^2 - 1) / w
+ *    dead = (PI - asin(epsilon/alpha) - atan(w*tau)) / w
+ * Returns invalid model if the oscillations do not fit the model
+ */
+PIDmodel PID::identify(uint16_t base_power, uint16_t base_temp, uint16_t delta_power, uint16_t alpha, uint16_t epsilon, uint32_t period) {
+	if (base_power == 0 || period == 0 || alpha <= epsilon) return PIDmodel();
+	double gain		= (double)base_temp / base_power;
+	double w		= 2000.0 * M_PI / period;				// rad/s, the period is in ms
+	double r		= 4.0 * delta_power * gain / (M_PI * alpha);
+	if (r <= 1.0) return PIDmodel();
+	double tau		= sqrt(r*r - 1.0) / w;
+	double dead		= (M_PI - asin((double)epsilon / alpha) - atan(w * tau)) / w;
+	if (dead <= 0) return PIDmodel();
+	return PIDmodel(constrain(round(gain * 256), 1, 0xFFFF), constrain(round(tau * 1000), 1, 0xFFFF), constrain(round(dead * 1000), 1, 0xFFFF));
+}
+
+/*
+ * The PI controller by SIMC rules with the closed loop time constant equal to the dead time:
+ *    Kp = tau / (gain * 2*dead); Ti = min(tau, 8*dead)
+ * With the Smith predictor the PID controls the delay free model, the dead time is excluded:
+ *    Kp = tau / (gain * dead); Ti = min(tau, 4*dead)
+ * Kp is limited by the PID tune mode range, see MTPID
+ */
+void PID::modelPIDparams(const PIDmodel &m, bool predictor) {
+	model(m, predictor);
+	if (!m.isValid()) return;
+	PIDparam pp = modelParams(m, predictor);
+	Kp = pp.Kp;
+	Ki = pp.Ki;
+	Kd = pp.Kd;
+	scale();
+}
+
+PIDparam PID::modelParams(const PIDmodel &m, bool predictor) {
+	const uint32_t T = ref_period;							// The control period of the coefficients, us
+	uint32_t lambda	= predictor?m.dead:2*m.dead;			// ms
+	uint32_t ti		= 4 * lambda;
+	if (ti > m.tau) ti = m.tau;
+	int32_t kp = ((int64_t)m.tau << (denominator_p + 8)) / ((int64_t)m.gain * lambda);
+	kp = constrain(kp, 1, 20000);
+	int32_t ki = ((int64_t)kp * T + ti * 500) / (ti * 1000);
+	return PIDparam(kp, ki, 0, Kb, Kc);
+}
+
+/*
+ * Follow the IRON model identified online (see RLS): the coefficients are built by the model as in modelPIDparams(),
+ * but they cannot leave the range of the base ones (the tuned or the default) more than twice,
+ * so the wrong model cannot make the loop unstable or sluggish. The derivative coefficient is kept.
+ * The small changes are ignored, the coefficients are changed bumpless, see PIDQ::gains()
+ */
+bool PID::adapt(const PIDmodel &m, const PIDparam &base) {
+	if (!m.isValid() || base.Kp <= 0 || base.Ki <= 0) return false;
+	PIDparam pp = modelParams(m, smith.isOn());
+	int32_t kp	= constrain(pp.Kp, base.Kp / 2, base.Kp * 2);
+	int32_t ki	= constrain(pp.Ki, (base.Ki + 1) / 2, base.Ki * 2);
+	if (abs(kp - Kp) <= Kp / 8 && abs(ki - Ki) <= Ki / 8 && Kd == base.Kd) return false;
+	retune(kp, ki, base.Kd);
+	return true;
+}
+
+int32_t PID::reqPower(int16_t temp_set, int16_t temp_curr, uint8_t frac) {
+	if (!smith.isOn())
+		return control(temp_set, temp_curr, frac);
+	int32_t p	= control(temp_set, temp_curr + smith.correction(), frac);
+	int32_t u	= frac?((p + (1 << (frac-1))) >> frac):p;
+	smith.update(constrain(u, pwr_low, pwr_high));
+	return p;
+}
+
+int32_t PID::control(int16_t temp_set, int16_t temp_curr, uint8_t frac) {
+#ifndef PID_V1
+	return engine.update(temp_set, temp_curr, frac);
+#else
 	if (temp_h0 == 0) {										// Use direct formulae because do not know previous temperature
 		power 		= 0;
 		i_summ 		= 0;
 		i_summ += temp_set - temp_curr;
-		power = Kp*(temp_set - temp_curr) + Ki * i_summ;
+		power = Kp*(temp_set - temp_curr) + ki_t * i_summ + (i_start << denominator_p);
 	} else {
 		int32_t kp = Kp * (temp_h1 	- temp_curr);
-		int32_t ki = Ki * (temp_set	- temp_curr);
-		int32_t kd = Kd * (temp_h0 	+ temp_curr - 2 * temp_h1);
+		int32_t ki = ki_t * (temp_set	- temp_curr);
+		int32_t kd = kd_t * (temp_h0 	+ temp_curr - 2 * temp_h1);
 		int32_t delta_p = kp + ki + kd;
 		power += delta_p;									// Power is stored multiplied by denominator!
 	}
 	temp_h0 = temp_h1;
 	temp_h1 = temp_curr;
-	int32_t pwr = power + (1 << (denominator_p-1));			// prepare the power to divide by denominator, round the result
-	pwr >>= denominator_p;									// divide by the denominator
-	return pwr;
+	if (frac >= denominator_p) frac = denominator_p - 1;
+	uint8_t shift = denominator_p - frac;					// Keep frac bits of the fraction part
+	int32_t pwr = power + (1 << (shift-1));					// prepare the power to divide by denominator, round the result
+	pwr >>= shift;											// divide by the denominator
+	return pwr + (ff_power << frac);
+#endif
+}
+
+void SMITH::model(const PIDmodel &m, uint32_t period_us) {
+	on = m.isValid();
+	if (!on) return;
+	gain	= m.gain;
+	alpha	= ((uint64_t)period_us << 16) / ((uint32_t)m.tau * 1000);
+	if (alpha > (1 << 16)) alpha = 1 << 16;
+	uint32_t d = ((uint32_t)m.dead * 1000 + period_us/2) / period_us;
+	delay	= constrain(d, 1, delay_max - 1);
+}
+
+void SMITH::reset(void) {
+	for (uint8_t i = 0; i < delay_max; ++i)
+		y[i] = 0;
+	head = 0;
+}
+
+void SMITH::update(int32_t power) {
+	int32_t prev	= y[head];
+	head			= (head + 1) & (delay_max - 1);
+	y[head]			= prev + (((int64_t)gain * power - prev) * alpha >> 16);
+}
+
+void RLS::init(const PIDmodel &prior, uint16_t period_ms) {
+	if (period_ms) period = period_ms;
+	bool known	= prior.isValid();
+	PIDmodel m	= known?prior:PIDmodel::typical();
+	double a	= exp(-(double)period / m.tau);
+	theta[0]	= a;
+	theta[1]	= (double)m.gain / 256.0 * (1.0 - a);
+	double pv	= known?p_prior:p_default;					// The weaker start for the default model
+	P[0][0]		= pv;
+	P[0][1]		= 0;
+	P[1][0]		= 0;
+	P[1][1]		= pv;
+	dead		= m.dead;
+	uint32_t d	= ((uint32_t)dead + period/2) / period;
+	delay		= constrain(d, 1, hist_len - 1);
+	err2		= 0;
+	gain_avg	= m.gain;
+	tau_avg		= m.tau;
+	n			= 0;
+	conf		= 0;
+	head		= 0;
+	filled		= 0;
+}
+
+void RLS::update(int16_t temp, int16_t power) {
+	head		= (head + 1) & (hist_len - 1);
+	u[head]		= power;
+	if (filled < hist_len) ++filled;
+	if (filled > delay) {									// y_prev and the delayed power are known
+		double phi[2]	= { y_prev / scale, u[(head - delay) & (hist_len - 1)] / scale };
+		double e		= temp / scale;						// The prediction error
+		double pp[2];										// P * phi
+		double r		= 0;								// phi' * P * phi
+		for (uint8_t i = 0; i < 2; ++i) {
+			e	   -= theta[i] * phi[i];
+			pp[i]	= P[i][0]*phi[0] + P[i][1]*phi[1];
+			r	   += phi[i] * pp[i];
+		}
+		for (uint8_t i = 0; i < 2; ++i)
+			theta[i] += pp[i] * e / (1.0 + r);
+		double f = (r > 0)?(lambda - (1.0 - lambda) / r):0;	// The directional forgetting
+		if (f != 0) {
+			double den = 1.0 / f + r;
+			for (uint8_t i = 0; i < 2; ++i) {
+				for (uint8_t j = 0; j <= i; ++j) {			// Keep P symmetric
+					P[i][j] -= pp[i] * pp[j] / den;
+					P[j][i]  = P[i][j];
+				}
+			}
+		}
+		err2 = (n == 0)?e*e:(err2 + (e*e - err2) / 32);
+		if (n < 0xFFFF) ++n;
+		evaluate();
+	}
+	y_prev		= temp;
+}
+
+PIDmodel RLS::model(void) {
+	double a = theta[0];
+	double b = theta[1];
+	if (a <= 0 || a >= 1 || b <= 0) return PIDmodel();
+	double gain	= b / (1.0 - a) * 256.0;
+	double tau	= -(double)period / log(a);
+	if (gain >= 0xFFFF || tau >= 0xFFFF) return PIDmodel();
+	return PIDmodel(constrain(round(gain), 1, 0xFFFF), constrain(round(tau), 1, 0xFFFF), dead);
+}
+
+/*
+ * The parameter covariance is err2 * P, the standard deviations of the model are taken by the linearization:
+ *    d(gain) = (b*da/(1-a) + db) / (1-a); d(tau) = T*da / (a * ln(a)^2)
+ */
+void RLS::evaluate(void) {
+	conf = 0;
+	double a = theta[0];
+	double b = theta[1];
+	if (a <= 0 || a >= 1 || b <= 0) return;
+	double la	= log(a);
+	double gain	= b / (1.0 - a);
+	double tau	= -period / la;
+	if (gain * 256.0 >= 0xFFFF || tau >= 0xFFFF) return;	// See model()
+	gain_avg   += (gain * 256.0 - gain_avg) / drift_len;
+	tau_avg	   += (tau - tau_avg) / drift_len;
+	if (n < min_samples) return;
+	double ga	= b / ((1.0 - a) * (1.0 - a));				// d(gain)/da
+	double gb	= 1.0 / (1.0 - a);							// d(gain)/db
+	double vg	= err2 * (ga*ga*P[0][0] + 2*ga*gb*P[0][1] + gb*gb*P[1][1]);
+	double ta	= 1.0 / (a * la * la);						// d(tau)/da / T
+	double vt	= err2 * ta*ta*P[0][0];
+	double r	= sqrt(vg > 0?vg:0) / gain;					// The relative uncertainty
+	double rt	= sqrt(vt > 0?vt:0) * -la;
+	if (rt > r) r = rt;
+	rt			= fabs(gain * 256.0 - gain_avg) / (gain * 256.0);
+	if (rt > r) r = rt;
+	rt			= fabs(tau - tau_avg) / tau;
+	if (rt > r) r = rt;
+	if (r < 1.0)
+		conf = round(100.0 * (1.0 - r));
+}
+
+void KALMAN::model(const PIDmodel &m) {
+	PIDmodel k	= m.isValid()?m:PIDmodel::typical();
+	gain		= k.gain;
+	tau			= k.tau;
+	dead		= k.dead;
+	scale();
+}
+
+// The drift is the temperature change per control period, so it is scaled with the period
+void KALMAN::controlPeriod(uint32_t us) {
+	if (us == 0 || us == period_us) return;
+	if (!first) {
+		drift	= (int64_t)drift * us / period_us;
+		p_td	= p_td * us / period_us;
+		p_dd	= p_dd * us / period_us * us / period_us;
+	}
+	period_us	= us;
+	scale();
+}
+
+// The process noise of the temperature is white, the drift is a random walk of the temperature rate
+void KALMAN::scale(void) {
+	const uint32_t ref = PID::ref_period;
+	if (tau) {
+		uint64_t a	= ((uint64_t)period_us << 24) / ((uint32_t)tau * 1000);
+		alpha		= (a > (1 << 24))?(1 << 24):a;
+	}
+	uint32_t d	= ((uint32_t)dead * 1000 + period_us/2) / period_us;
+	delay		= constrain(d, 1, hist_len - 1);
+	q_t			= q_temp * period_us / ref;
+	q_d			= q_drift * period_us / ref * period_us / ref * period_us / ref;
+	if (q_d < 1) q_d = 1;
+}
+
+/*
+ * The covariance P is predicted already, see predict(). With the measurement matrix H = [1 0]
+ *    S = Ptt + R;	Kt = Ptt / S;	Kd = Ptd / S;	P = (I - K*H) * P
+ * so Ptt = Kt*R, Ptd = Kd*R and Pdd -= Kd*Ptd: one division per gain
+ */
+int32_t KALMAN::update(int32_t t, uint8_t frac) {
+	int32_t x = t << (16 - frac);
+	if (!first && abs(x - temp) > (jump << 16))
+		first = true;
+	if (first) {
+		first	= false;
+		temp	= x;
+		drift	= 0;
+		p_tt	= r_noise;
+		p_td	= 0;
+		p_dd	= p_drift;
+	} else {
+		int64_t s	= p_tt + r_noise;
+		int32_t kt	= (p_tt << 24) / s;
+		int32_t kd	= (p_td << 24) / s;
+		int32_t e	= x - temp;
+		temp	   += ((int64_t)kt * e + (1 << 23)) >> 24;
+		drift	   += ((int64_t)kd * e + (1 << 23)) >> 24;
+		p_dd	   -= (kd * p_td) >> 24;
+		p_td		= (kd * r_noise) >> 24;
+		p_tt		= (kt * r_noise) >> 24;
+	}
+	return (temp + (1 << 15)) >> 16;
+}
+
+// The model with the power that reaches the sensor in the next period and the drift
+int32_t KALMAN::rate(void) {
+	if (first) return 0;
+	int64_t ud	= u[(uint8_t)(head + 1 - delay) & (hist_len - 1)];
+	int64_t y	= ((int64_t)gain * ud << 8) - temp;
+	int64_t r	= ((y * alpha) >> 24) + drift;			// Per control period, 16 fractional bits
+	return (r * 1000000 / (int64_t)period_us) >> 16;
+}
+
+/*
+ * The drift is the temperature change per period the model does not explain, the power that makes it by the model:
+ *    alpha * gain * Ul = -D
+ * The positive loss is the power taken away from the IRON (the solder load)
+ */
+int32_t KALMAN::loss(void) {
+	if (first || alpha == 0 || gain == 0) return 0;
+	return -(((int64_t)drift << 16) / ((int64_t)alpha * gain));
+}
+
+/*
+ * The state transition matrix F = [f 1; 0 1], f = 1 - alpha
+ *    P = F * P * F' + Q
+ */
+void KALMAN::predict(int32_t power) {
+	head		= (head + 1) & (hist_len - 1);
+	u[head]		= constrain(power, 0, 0x7FFF);
+	if (first) return;
+	int64_t ud	= u[(uint8_t)(head - delay) & (hist_len - 1)];
+	int64_t y	= ((int64_t)gain * ud << 8) - temp;		// The steady temperature of the delayed power less the current one, 16 fractional bits
+	temp	   += ((y * alpha) >> 24) + drift;
+	int64_t f	= (1 << 24) - alpha;
+	int64_t ff	= (f * f) >> 24;
+	p_tt		= ((ff * p_tt) >> 24) + ((2 * f * p_td) >> 24) + p_dd + q_t;
+	p_td		= ((f * p_td) >> 24) + p_dd;
+	p_dd	   += q_d;
 }
 
 void PIDTUNE::start(uint16_t base_pwr, uint16_t delta_power, uint16_t base_temp, uint16_t delta_temp) {
@@ -24,6 +24,13 @@ int32_t EMP_AVERAGE::read(void) {
 	return (emp_data + round_v) / emp_k;
 }
 
+void EMP_AVERAGE::rescale(uint8_t h_length) {
+	if (h_length == 0) h_length = 1;
+	if (h_length == emp_k) return;
+	emp_data = (uint64_t)emp_data * h_length / emp_k;
+	emp_k	 = h_length;
+}
+
 int32_t	HIST::read(void) {
 	int32_t sum = 0;
 	if (len == 0) return 0;
@@ -82,6 +89,14 @@ bool SWITCH::status(void) {
     return mode;
 }
 
+void SWITCH::set(bool on) {
+	if (on)
+		EMP_AVERAGE::preset(on_val  + (on_val  >> 1));
+	else
+		EMP_AVERAGE::preset(off_val - (off_val >> 1));
+	mode = on;
+}
+
 void SWITCH::update(uint16_t value) {
 	uint16_t max_val = on_val  + (on_val  >> 1);
 	uint16_t min_val = off_val - (off_val >> 1);
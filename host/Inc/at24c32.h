@@ -0,0 +1,41 @@
+/*
+ * at24c32.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * The model of the AT24C32 I2C EEPROM IC: 4096 bytes, 32-bytes pages.
+ * The page write rolls over inside the page, the sequential read rolls over the whole memory.
+ * The IC does not acknowledge its address during internal write cycle (5 ms).
+ * The power loss can be scheduled: the IC takes the given number of page writes, then fails all the next ones.
+ */
+
+#ifndef AT24C32_H_
+#define AT24C32_H_
+
+#include <stdint.h>
+
+class AT24C32 {
+	public:
+		AT24C32(void)										{ erase(); }
+		void		erase(void);
+		void		connect(bool c)							{ connected = c; }
+		bool		isReady(uint64_t now)					{ return connected && now >= busy_till; }
+		bool		read(uint64_t now, uint16_t addr, uint8_t* data, uint16_t size);
+		bool		write(uint64_t now, uint16_t addr, const uint8_t* data, uint16_t size);
+		uint8_t*	memory(void)							{ return mem; }
+		uint32_t	writeCycles(void)						{ return writes; }
+		void		powerLoss(uint32_t after)				{ write_left = after; }	// The number of page writes before the power is lost
+		void		powerOn(void)							{ write_left = no_loss; }
+	private:
+		uint8_t		mem[4096];
+		bool		connected		= true;
+		uint64_t	busy_till		= 0;					// The time (CPU clocks) when the internal write cycle finishes
+		uint32_t	writes			= 0;					// The number of page write cycles since erase
+		uint32_t	write_left		= no_loss;				// The page writes till the power loss
+		static const uint32_t	no_loss	= 0xFFFFFFFF;
+		const uint16_t	size		= 4096;
+		const uint16_t	page		= 32;
+		const uint32_t	write_cycle	= 72000 * 5;			// 5 ms in CPU clocks
+};
+
+#endif /* AT24C32_H_ */
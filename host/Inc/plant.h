@@ -0,0 +1,74 @@
+/*
+ * plant.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * The thermal model of the T12 soldering tip cartridge for the host twin.
+ * Two thermal nodes are used: the heater with the thermocouple and the tip body.
+ *   C_h * dT_h/dt = P - G_ht * (T_h - T_t) - G_ha * (T_h - T_a)
+ *   C_t * dT_t/dt = G_ht * (T_h - T_t) - G_ta * (T_t - T_a) - G_load * (T_t - T_a)
+ * The thermocouple reading follows the heater node with the first order lag (tc_lag).
+ * The thermocouple amplifier saturates while the heater is powered and settles exponentially after the power is off.
+ * The ADC readings are translated from Celsius by the default tip calibration, see TIP_CFG::defaultCalibration()
+ * The heater power is P = V^2 / R when the heater is powered.
+ * A temperature conversion can be corrupted with the given probability: the reading is replaced by the random value.
+ * The current sense can be broken for a while, the heater is still powered (the heater current contact dropout).
+ */
+
+#ifndef PLANT_H_
+#define PLANT_H_
+
+#include "twin.h"
+
+typedef struct s_t12_param T12_PARAM;
+struct s_t12_param {
+	double		voltage;									// Power supply voltage, V
+	double		resistance;									// Heater resistance, Ohm
+	double		c_heater;									// Heat capacity of the heater node, J/K
+	double		c_tip;										// Heat capacity of the tip node, J/K
+	double		g_ht;										// Thermal conductance heater -> tip, W/K
+	double		g_ha;										// Thermal conductance heater -> ambient, W/K
+	double		g_ta;										// Thermal conductance tip -> ambient, W/K
+	double		tc_lag;										// Thermocouple time constant, s
+	double		tc_settle;									// Thermocouple amplifier settle time constant after power off, s
+	double		noise;										// RMS noise of ADC readings, counts
+	double		glitch;										// Probability of a corrupted IRON temperature conversion (EMI, loose contact)
+	uint16_t	current;									// ADC reading of the heater current when powered
+};
+
+class TWIN_T12_PLANT : public TWIN_PLANT {
+	public:
+		TWIN_T12_PLANT(void);
+		void				init(const T12_PARAM* param, double ambient = 25.0);
+		void				connect(bool c)					{ connected = c; }
+		void				currentSense(bool s)			{ c_sense = s; }	// The current amplifier reads zero while off: the heater contact dropout
+		void				load(double g)					{ g_load = g; }	// Apply solder joint load: extra conductance tip -> ambient, W/K
+		void				ambient(double t)				{ t_a = t; }
+		double				heaterTemp(void)				{ return t_h; }
+		double				tipTemp(void)					{ return t_t; }
+		double				sensorTemp(void)				{ return t_s; }
+		double				energy(void)					{ return e_j; }	// Energy consumed by the heater since init, J
+		double				maxPower(void)					{ return p_max; }
+		virtual void		heater(bool on, uint32_t clocks);
+		virtual uint16_t	adc(uint32_t channel, bool heater_on);
+		static const T12_PARAM	def;
+	private:
+		uint16_t			tempToADC(double t);
+		uint16_t			ambientToADC(double t);
+		double				noise(void);
+		double				uniform(void);					// Uniform random value in [0, 1)
+		T12_PARAM			p;
+		double				p_max		= 0;				// Heater power when powered, W
+		double				t_a			= 25.0;				// Ambient temperature
+		double				t_h			= 25.0;				// Heater node temperature
+		double				t_t			= 25.0;				// Tip node temperature
+		double				t_s			= 25.0;				// Thermocouple temperature
+		double				g_load		= 0;
+		double				e_j			= 0;
+		double				off_time	= 1.0;				// The time since the heater was switched off, s
+		bool				connected	= true;
+		bool				c_sense		= true;
+		uint32_t			seed		= 1;				// Pseudo random generator state, the readings are reproducible
+};
+
+#endif /* PLANT_H_ */
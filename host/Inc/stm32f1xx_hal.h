@@ -0,0 +1,317 @@
+/*
+ * stm32f1xx_hal.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Host "digital twin" stand-in of the STM32F1 HAL.
+ * Only the types, registers and entry points used by the controller sources are declared here.
+ * The peripherals are emulated in host/Src/hal.cpp, the timing is driven by the twin clock (see twin.h)
+ * All the calls are executed on the host synchronously, interrupt handlers are called by the twin scheduler.
+ */
+
+#ifndef __STM32F1xx_HAL_H
+#define __STM32F1xx_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __IO				volatile
+
+typedef enum { HAL_OK = 0x00U, HAL_ERROR = 0x01U, HAL_BUSY = 0x02U, HAL_TIMEOUT = 0x03U } HAL_StatusTypeDef;
+typedef enum { RESET = 0, SET = !RESET } FlagStatus, ITStatus;
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+
+#define HAL_MAX_DELAY		0xFFFFFFFFU
+
+//---------------------------------------- GPIO ------------------------------------------------------
+typedef struct {
+	__IO uint32_t	CRL, CRH, IDR, ODR, BSRR, BRR, LCKR;
+} GPIO_TypeDef;
+
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+
+#define GPIO_PIN_0			((uint16_t)0x0001)
+#define GPIO_PIN_1			((uint16_t)0x0002)
+#define GPIO_PIN_2			((uint16_t)0x0004)
+#define GPIO_PIN_3			((uint16_t)0x0008)
+#define GPIO_PIN_4			((uint16_t)0x0010)
+#define GPIO_PIN_5			((uint16_t)0x0020)
+#define GPIO_PIN_6			((uint16_t)0x0040)
+#define GPIO_PIN_7			((uint16_t)0x0080)
+#define GPIO_PIN_8			((uint16_t)0x0100)
+#define GPIO_PIN_9			((uint16_t)0x0200)
+#define GPIO_PIN_10			((uint16_t)0x0400)
+#define GPIO_PIN_11			((uint16_t)0x0800)
+#define GPIO_PIN_12			((uint16_t)0x1000)
+#define GPIO_PIN_13			((uint16_t)0x2000)
+#define GPIO_PIN_14			((uint16_t)0x4000)
+#define GPIO_PIN_15			((uint16_t)0x8000)
+
+extern GPIO_TypeDef		twin_gpioa, twin_gpiob, twin_gpioc, twin_gpiod;
+#define GPIOA				(&twin_gpioa)
+#define GPIOB				(&twin_gpiob)
+#define GPIOC				(&twin_gpioc)
+#define GPIOD				(&twin_gpiod)
+
+#define EXTI0_IRQn			(6)
+#define __HAL_GPIO_EXTI_CLEAR_IT(__EXTI_LINE__)	((void)(__EXTI_LINE__))
+
+GPIO_PinState		HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
+void				HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+
+//---------------------------------------- TIM -------------------------------------------------------
+typedef struct {
+	__IO uint32_t	CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR, RCR;
+	__IO uint32_t	CCR1, CCR2, CCR3, CCR4, BDTR, DCR, DMAR;
+} TIM_TypeDef;
+
+extern TIM_TypeDef		twin_tim2, twin_tim4;
+#define TIM2				(&twin_tim2)
+#define TIM4				(&twin_tim4)
+
+#define TIM_CHANNEL_1		(0x00000000U)
+#define TIM_CHANNEL_2		(0x00000004U)
+#define TIM_CHANNEL_3		(0x00000008U)
+#define TIM_CHANNEL_4		(0x0000000CU)
+
+#define TIM_CR1_ARPE		(0x00000080U)			// Auto-reload preload enable
+#define TIM_CR2_MMS			(0x00000070U)			// Master mode selection: TRGO source
+#define TIM_TRGO_RESET		(0x00000000U)
+#define TIM_TRGO_UPDATE		(0x00000020U)
+#define TIM_TRGO_OC3REF		(0x00000060U)
+
+typedef enum {
+	HAL_TIM_ACTIVE_CHANNEL_1		= 0x01U,
+	HAL_TIM_ACTIVE_CHANNEL_2		= 0x02U,
+	HAL_TIM_ACTIVE_CHANNEL_3		= 0x04U,
+	HAL_TIM_ACTIVE_CHANNEL_4		= 0x08U,
+	HAL_TIM_ACTIVE_CHANNEL_CLEARED	= 0x00U
+} HAL_TIM_ActiveChannel;
+
+typedef struct {
+	uint32_t		Prescaler;
+	uint32_t		CounterMode;
+	uint32_t		Period;
+	uint32_t		ClockDivision;
+	uint32_t		RepetitionCounter;
+	uint32_t		AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+	TIM_TypeDef*			Instance;
+	TIM_Base_InitTypeDef	Init;
+	HAL_TIM_ActiveChannel	Channel;
+} TIM_HandleTypeDef;
+
+HAL_StatusTypeDef	HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef	HAL_TIM_OC_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef	HAL_TIM_OC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef	HAL_TIM_OC_Start_DMA(TIM_HandleTypeDef *htim, uint32_t Channel, uint32_t *pData, uint16_t Length);
+void				HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim);
+
+//---------------------------------------- ADC & DMA -------------------------------------------------
+typedef struct {
+	__IO uint32_t	SR, CR1, CR2, SMPR1, SMPR2, JOFR1, JOFR2, JOFR3, JOFR4, HTR, LTR;
+	__IO uint32_t	SQR1, SQR2, SQR3, JSQR, JDR1, JDR2, JDR3, JDR4, DR;
+} ADC_TypeDef;
+
+extern ADC_TypeDef		twin_adc1, twin_adc2;
+#define ADC1				(&twin_adc1)
+#define ADC2				(&twin_adc2)
+
+#define ADC_CHANNEL_0		(0x00000000U)
+#define ADC_CHANNEL_1		(0x00000001U)
+#define ADC_CHANNEL_2		(0x00000002U)
+#define ADC_CHANNEL_3		(0x00000003U)
+#define ADC_CHANNEL_4		(0x00000004U)
+#define ADC_CHANNEL_5		(0x00000005U)
+#define ADC_CHANNEL_6		(0x00000006U)
+#define ADC_CHANNEL_7		(0x00000007U)
+
+#define ADC_REGULAR_RANK_1	(0x00000001U)
+#define ADC_REGULAR_RANK_2	(0x00000002U)
+#define ADC_REGULAR_RANK_3	(0x00000003U)
+#define ADC_REGULAR_RANK_4	(0x00000004U)
+#define ADC_REGULAR_RANK_5	(0x00000005U)
+#define ADC_REGULAR_RANK_6	(0x00000006U)
+#define ADC_REGULAR_RANK_7	(0x00000007U)
+#define ADC_REGULAR_RANK_8	(0x00000008U)
+#define ADC_REGULAR_RANK_9	(0x00000009U)
+#define ADC_REGULAR_RANK_10	(0x0000000AU)
+#define ADC_REGULAR_RANK_11	(0x0000000BU)
+#define ADC_REGULAR_RANK_12	(0x0000000CU)
+#define ADC_REGULAR_RANK_13	(0x0000000DU)
+#define ADC_REGULAR_RANK_14	(0x0000000EU)
+#define ADC_REGULAR_RANK_15	(0x0000000FU)
+#define ADC_REGULAR_RANK_16	(0x00000010U)
+
+#define ADC_SAMPLETIME_1CYCLE_5		(0x00000000U)
+#define ADC_SAMPLETIME_7CYCLES_5	(0x00000001U)
+#define ADC_SAMPLETIME_13CYCLES_5	(0x00000002U)
+#define ADC_SAMPLETIME_28CYCLES_5	(0x00000003U)
+#define ADC_SAMPLETIME_41CYCLES_5	(0x00000004U)
+#define ADC_SAMPLETIME_55CYCLES_5	(0x00000005U)
+#define ADC_SAMPLETIME_71CYCLES_5	(0x00000006U)
+#define ADC_SAMPLETIME_239CYCLES_5	(0x00000007U)
+
+#define ADC_INJECTED_RANK_1	(0x00000001U)
+#define ADC_INJECTED_RANK_2	(0x00000002U)
+#define ADC_INJECTED_RANK_3	(0x00000003U)
+#define ADC_INJECTED_RANK_4	(0x00000004U)
+
+#define ADC_SOFTWARE_START					(0x000E0000U)	// ADC_CR2_EXTSEL
+#define ADC_EXTERNALTRIGCONV_T2_CC2			(0x00060000U)
+#define ADC_INJECTED_SOFTWARE_START			(0x00007000U)	// ADC_CR2_JEXTSEL
+#define ADC_EXTERNALTRIGINJECCONV_T2_TRGO	(0x00002000U)
+
+typedef struct {
+	uint32_t		DataAlign;
+	uint32_t		ScanConvMode;
+	uint32_t		ContinuousConvMode;
+	uint32_t		NbrOfConversion;
+	uint32_t		DiscontinuousConvMode;
+	uint32_t		NbrOfDiscConversion;
+	uint32_t		ExternalTrigConv;
+} ADC_InitTypeDef;
+
+typedef struct {
+	uint32_t		Channel;
+	uint32_t		Rank;
+	uint32_t		SamplingTime;
+} ADC_ChannelConfTypeDef;
+
+typedef struct {
+	uint32_t		InjectedChannel;
+	uint32_t		InjectedRank;
+	uint32_t		InjectedSamplingTime;
+	uint32_t		InjectedOffset;
+	uint32_t		InjectedNbrOfConversion;
+	uint32_t		InjectedDiscontinuousConvMode;
+	uint32_t		AutoInjectedConv;
+	uint32_t		ExternalTrigInjecConv;
+} ADC_InjectionConfTypeDef;
+
+#define DMA_NORMAL			(0x00000000U)
+#define DMA_CIRCULAR		(0x00000020U)
+
+typedef struct {
+	uint32_t		Direction;
+	uint32_t		PeriphInc;
+	uint32_t		MemInc;
+	uint32_t		PeriphDataAlignment;
+	uint32_t		MemDataAlignment;
+	uint32_t		Mode;
+	uint32_t		Priority;
+} DMA_InitTypeDef;
+
+typedef struct {
+	void*			Instance;
+	DMA_InitTypeDef	Init;
+} DMA_HandleTypeDef;
+
+typedef struct {
+	ADC_TypeDef*		Instance;
+	ADC_InitTypeDef		Init;
+	DMA_HandleTypeDef*	DMA_Handle;
+	__IO uint32_t		State;
+	__IO uint32_t		ErrorCode;
+} ADC_HandleTypeDef;
+
+HAL_StatusTypeDef	HAL_ADC_ConfigChannel(ADC_HandleTypeDef* hadc, ADC_ChannelConfTypeDef* sConfig);
+HAL_StatusTypeDef	HAL_ADC_Start(ADC_HandleTypeDef* hadc);
+HAL_StatusTypeDef	HAL_ADC_Stop(ADC_HandleTypeDef* hadc);
+HAL_StatusTypeDef	HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef* hadc);
+HAL_StatusTypeDef	HAL_ADCEx_MultiModeStart_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length);
+HAL_StatusTypeDef	HAL_ADCEx_MultiModeStop_DMA(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef	HAL_ADCEx_InjectedConfigChannel(ADC_HandleTypeDef* hadc, ADC_InjectionConfTypeDef* sConfigInjected);
+HAL_StatusTypeDef	HAL_ADCEx_InjectedStart(ADC_HandleTypeDef* hadc);
+HAL_StatusTypeDef	HAL_ADCEx_InjectedStart_IT(ADC_HandleTypeDef* hadc);
+HAL_StatusTypeDef	HAL_ADCEx_InjectedStop(ADC_HandleTypeDef* hadc);
+HAL_StatusTypeDef	HAL_ADCEx_InjectedStop_IT(ADC_HandleTypeDef* hadc);
+uint32_t			HAL_ADCEx_InjectedGetValue(ADC_HandleTypeDef* hadc, uint32_t InjectedRank);
+void				HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc);
+void				HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc);
+void				HAL_ADCEx_InjectedConvCpltCallback(ADC_HandleTypeDef* hadc);
+void				HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc);
+void				HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef *hadc);
+
+//---------------------------------------- I2C & SPI -------------------------------------------------
+typedef enum {
+	HAL_I2C_STATE_RESET		= 0x00U,
+	HAL_I2C_STATE_READY		= 0x20U,
+	HAL_I2C_STATE_BUSY		= 0x24U
+} HAL_I2C_StateTypeDef;
+
+typedef enum {
+	HAL_SPI_STATE_RESET		= 0x00U,
+	HAL_SPI_STATE_READY		= 0x01U,
+	HAL_SPI_STATE_BUSY		= 0x02U
+} HAL_SPI_StateTypeDef;
+
+#define I2C_MEMADD_SIZE_8BIT	(0x00000001U)
+#define I2C_MEMADD_SIZE_16BIT	(0x00000010U)
+
+typedef struct {
+	void*					Instance;
+	__IO HAL_I2C_StateTypeDef State;
+} I2C_HandleTypeDef;
+
+typedef struct {
+	void*					Instance;
+	__IO HAL_SPI_StateTypeDef State;
+} SPI_HandleTypeDef;
+
+HAL_StatusTypeDef	HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout);
+HAL_StatusTypeDef	HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef	HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef	HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi);
+
+//---------------------------------------- Core ------------------------------------------------------
+typedef struct {
+	__IO uint32_t	CPUID, ICSR, VTOR, AIRCR, SCR, CCR;
+} SCB_Type;
+
+typedef struct {
+	__IO uint32_t	CTRL, CYCCNT;
+} DWT_Type;
+
+typedef struct {
+	__IO uint32_t	DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+
+extern SCB_Type			twin_scb;
+extern DWT_Type			twin_dwt;
+extern CoreDebug_Type	twin_coredebug;
+#define SCB					(&twin_scb)
+#define DWT					(twinDWT())				// The cycle counter is updated on each access, see hal.cpp
+#define CoreDebug			(&twin_coredebug)
+
+#define SCB_ICSR_PENDSVSET_Msk			(1UL << 28)
+#define DWT_CTRL_CYCCNTENA_Msk			(1UL)
+#define CoreDebug_DEMCR_TRCENA_Msk		(1UL << 24)
+
+DWT_Type*			twinDWT(void);
+#define __DMB()				__sync_synchronize()	// Data memory barrier
+
+// The exceptions of the priority value not less than BASEPRI are masked, 0 - no masking. See pendSV() in hal.cpp
+#define __NVIC_PRIO_BITS	(4)
+extern uint32_t		twin_basepri;
+static inline uint32_t	__get_BASEPRI(void)				{ return twin_basepri;	}
+static inline void		__set_BASEPRI(uint32_t v)		{ twin_basepri = v & 0xFF;	}
+static inline void		__set_BASEPRI_MAX(uint32_t v)	{ v &= 0xFF; if (v && (twin_basepri == 0 || v < twin_basepri)) twin_basepri = v;	}
+
+uint32_t			HAL_GetTick(void);
+void				HAL_Delay(uint32_t Delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F1xx_HAL_H */
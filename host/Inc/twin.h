@@ -0,0 +1,103 @@
+/*
+ * twin.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Host "digital twin" of the controller hardware.
+ * The controller sources from the Src directory are compiled for the host and linked against the HAL stand-in.
+ * The twin emulates the peripherals used by the controller:
+ *   TIM2		- IRON PWM on CHANNEL1 (CCR1 and ARR are preloaded on update event), compare interrupts on CHANNEL3 and CHANNEL4
+ *   TIM4		- buzzer, the registers are kept only
+ *   ADC1/ADC2	- dual mode with DMA, the readings are taken from the attached plant (TWIN_PLANT)
+ *   I2C1		- AT24C32 EEPROM IC at 0x50
+ *   OLED		- in-memory u8g2 frame buffer
+ * The time is counted in CPU clocks (72 MHz), the interrupt handlers are called by the twin scheduler
+ * between the calls of the main loop, so the main loop code is atomic in respect of the interrupts.
+ * The pending PendSV exception is served right after the interrupt handler that requested it (tail-chaining).
+ * The interrupt handlers take no twin time, so inside the handler DWT->CYCCNT advances by the host time
+ * scaled to the CPU clock. The host time of each handler is also accounted in TWIN_ISR_STAT.
+ */
+
+#ifndef TWIN_H_
+#define TWIN_H_
+
+#include "main.h"
+#include "u8g2.h"
+#include "pid.h"
+#include "cfgtypes.h"
+
+#define TWIN_CPU_CLOCK		(72000000UL)			// CPU clock, Hz
+#define TWIN_ADC_CLK_DIV	(6)						// ADC clock is CPU/6, one conversion takes sampling time + 12.5 ADC clocks
+#define TWIN_EEPROM_SIZE	(4096)					// AT24C32 capacity, bytes
+
+/*
+ * The analog world connected to the controller: the IRON, the tip and the ambient temperature sensor.
+ * heater()	- the twin reports the state of the IRON power switch for the elapsed interval (CPU clocks)
+ * adc()	- the reading of the analog channel (ADC_CHANNEL_x) at the moment of conversion, 12 bits
+ */
+class TWIN_PLANT {
+	public:
+		TWIN_PLANT(void)									{ }
+		virtual				~TWIN_PLANT(void)				{ }
+		virtual void		heater(bool on, uint32_t clocks)	{ }
+		virtual uint16_t	adc(uint32_t channel, bool heater_on) = 0;
+};
+
+// The plant with fixed readings, no thermal process at all
+class TWIN_STATIC_PLANT : public TWIN_PLANT {
+	public:
+		TWIN_STATIC_PLANT(uint16_t temp = 0, uint16_t current = 2000, uint16_t ambient = 2048)
+													{ set(temp, current, ambient); }
+		void				set(uint16_t temp, uint16_t current, uint16_t ambient);
+		virtual uint16_t	adc(uint32_t channel, bool heater_on);
+	private:
+		uint16_t	t_iron	= 0;							// IRON temperature, internal units
+		uint16_t	c_iron	= 0;							// The current through the IRON when it is powered
+		uint16_t	t_amb	= 0;							// Ambient thermistor reading
+};
+
+// Host time spent in the interrupt handlers called by the twin
+typedef struct s_twin_isr_stat TWIN_ISR_STAT;
+struct s_twin_isr_stat {
+	uint32_t	calls;
+	uint64_t	total_ns;
+	uint32_t	max_ns;
+};
+
+typedef enum { TWIN_ISR_TIM2 = 0, TWIN_ISR_ADC, TWIN_ISR_JADC, TWIN_ISR_EXTI, TWIN_ISR_PENDSV, TWIN_ISR_NUM } TWIN_ISR;
+
+// Low level twin functions, see hal.cpp
+void				twinReset(void);						// Reset the clock and all the peripherals, the EEPROM is erased
+void				twinAttach(TWIN_PLANT* plant);
+uint64_t			twinClocks(void);						// CPU clocks elapsed since reset
+void				twinAdvance(uint64_t clocks);			// Run the hardware (timers, ADC, interrupts)
+void				twinPin(GPIO_TypeDef* port, uint16_t pin, bool high);
+uint8_t*			twinEEPROM(void);						// The EEPROM IC content
+void				twinEEPROMConnected(bool connected);
+void				twinEEPROMPowerLoss(uint32_t writes);	// The EEPROM takes the given number of page writes, then fails all the next ones
+void				twinEEPROMPowerOn(void);				// The EEPROM takes the writes again
+uint64_t			twinHeaterOnClocks(void);				// Number of CPU clocks the IRON was powered since reset
+const TWIN_ISR_STAT* twinIsrStat(TWIN_ISR isr);
+void				twinIsrStatReset(void);
+
+// The OLED frame buffer, see u8g2.cpp
+uint32_t			twinFrames(void);						// Number of frames sent to the display
+const uint8_t*		twinFrame(void);						// Last sent frame, 128x64, u8g2 full buffer layout
+bool				twinFramePixel(uint8_t x, uint8_t y);
+uint8_t				twinFrameText(const u8g2_text_t** text);	// The strings of the last sent frame
+bool				twinFrameHas(const char* str);			// Whether the last sent frame has the string
+
+// High level functions, see twin.cpp
+void				twinActivateTip(uint8_t index);			// Prepare EEPROM: activate the tip, the configuration is built by the controller code
+void				twinPresetTemp(uint16_t temp);			// Prepare EEPROM: save the preset temperature (Celsius)
+void				twinPID(const PIDparam& pp);			// Prepare EEPROM: save the PID parameters
+void				twinSchedule(PID_SCHEDULE* ps);			// Prepare EEPROM: save the PID gain schedule
+void				twinTipPID(const PIDparam& pp, const PIDmodel& m, bool smith);	// Prepare EEPROM: save the PID parameters and the IRON model of the active tip
+void				twinBoost(uint8_t temp, uint8_t duration);	// Prepare EEPROM: save the boost temperature increment (Celsius) and duration (s)
+void				twinAdapt(bool on);						// Prepare EEPROM: enable the adaptive PID, see MWORK_IRON::trackModel()
+void				twinBoot(void);							// Call controller setup()
+void				twinRun(uint32_t ms);					// Call the controller main loop every millisecond
+void				twinEncoder(int16_t steps);				// Rotate the encoder
+void				twinButton(uint32_t ms);				// Press the encoder button for ms, then release it
+
+#endif /* TWIN_H_ */
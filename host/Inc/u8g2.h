@@ -0,0 +1,150 @@
+/*
+ * u8g2.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Host "digital twin" stand-in of the u8g2 library: in-memory monochrome frame buffer.
+ * The graphic primitives are rendered into the buffer, the strings are not rasterized:
+ * every drawStr() call is recorded into the text list of the frame, see twinFrameText() in twin.h
+ * The string width is calculated from the maximum glyph width of the font header.
+ */
+
+#ifndef U8G2_H
+#define U8G2_H
+
+#include "u8x8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint8_t	u8g2_uint_t;
+
+#define U8G2_FONT_SECTION(name)
+#define U8G2_DRAW_UPPER_RIGHT	0x01
+#define U8G2_DRAW_UPPER_LEFT	0x02
+#define U8G2_DRAW_LOWER_LEFT	0x04
+#define U8G2_DRAW_LOWER_RIGHT	0x08
+#define U8G2_DRAW_ALL			(U8G2_DRAW_UPPER_RIGHT|U8G2_DRAW_UPPER_LEFT|U8G2_DRAW_LOWER_RIGHT|U8G2_DRAW_LOWER_LEFT)
+
+#define U8G2_WIDTH				(128)
+#define U8G2_HEIGHT				(64)
+#define U8G2_TEXT_ITEMS			(24)
+#define U8G2_TEXT_LEN			(32)
+
+typedef struct u8g2_struct		u8g2_t;
+typedef struct u8g2_cb_struct	u8g2_cb_t;
+
+struct u8g2_cb_struct {
+	uint8_t		rotation;								// 0 - 0 degrees, 2 - 180 degrees
+};
+
+extern const u8g2_cb_t u8g2_cb_r0;
+extern const u8g2_cb_t u8g2_cb_r1;
+extern const u8g2_cb_t u8g2_cb_r2;
+extern const u8g2_cb_t u8g2_cb_r3;
+#define U8G2_R0	(&u8g2_cb_r0)
+#define U8G2_R1	(&u8g2_cb_r1)
+#define U8G2_R2	(&u8g2_cb_r2)
+#define U8G2_R3	(&u8g2_cb_r3)
+
+typedef struct {
+	uint8_t		x, y;
+	char		str[U8G2_TEXT_LEN];
+} u8g2_text_t;
+
+struct u8g2_struct {
+	u8x8_t					u8x8;						// Should be the first member, see u8g2_GetU8x8()
+	const u8g2_cb_t*		cb;
+	const uint8_t*			font;
+	uint8_t					draw_color;
+	uint8_t					buffer[U8G2_WIDTH * U8G2_HEIGHT / 8];	// The frame being drawn
+	u8g2_text_t				text[U8G2_TEXT_ITEMS];		// The strings of the frame being drawn
+	uint8_t					text_items;
+};
+
+#define u8g2_GetU8x8(u8g2) ((u8x8_t *)(u8g2))
+
+void		u8g2_Setup_sh1106_128x64_noname_f(u8g2_t *u8g2, const u8g2_cb_t *rotation, u8x8_msg_cb byte_cb, u8x8_msg_cb gpio_and_delay_cb);
+void		u8g2_Setup_ssd1306_128x64_noname_f(u8g2_t *u8g2, const u8g2_cb_t *rotation, u8x8_msg_cb byte_cb, u8x8_msg_cb gpio_and_delay_cb);
+void		u8g2_Setup_ssd1309_128x64_noname2_f(u8g2_t *u8g2, const u8g2_cb_t *rotation, u8x8_msg_cb byte_cb, u8x8_msg_cb gpio_and_delay_cb);
+
+void		u8g2_SetI2CAddress(u8g2_t *u8g2, uint8_t adr);
+#define u8g2_InitDisplay(u8g2)				u8x8_InitDisplay(u8g2_GetU8x8(u8g2))
+#define u8g2_ClearDisplay(u8g2)				u8x8_ClearDisplay(u8g2_GetU8x8(u8g2))
+#define u8g2_SetPowerSave(u8g2, is_enable)	u8x8_SetPowerSave(u8g2_GetU8x8(u8g2), (is_enable))
+#define u8g2_SetFlipMode(u8g2, mode)		u8x8_SetFlipMode(u8g2_GetU8x8(u8g2), (mode))
+void		u8g2_SetContrast(u8g2_t *u8g2, uint8_t value);
+void		u8g2_SetDisplayRotation(u8g2_t *u8g2, const u8g2_cb_t *u8g2_cb);
+u8g2_uint_t	u8g2_GetDisplayHeight(u8g2_t *u8g2);
+u8g2_uint_t	u8g2_GetDisplayWidth(u8g2_t *u8g2);
+
+void		u8g2_SendBuffer(u8g2_t *u8g2);
+void		u8g2_ClearBuffer(u8g2_t *u8g2);
+void		u8g2_FirstPage(u8g2_t *u8g2);
+uint8_t		u8g2_NextPage(u8g2_t *u8g2);
+uint8_t*	u8g2_GetBufferPtr(u8g2_t *u8g2);
+uint8_t		u8g2_GetBufferTileHeight(u8g2_t *u8g2);
+uint8_t		u8g2_GetBufferTileWidth(u8g2_t *u8g2);
+uint8_t		u8g2_GetBufferCurrTileRow(u8g2_t *u8g2);
+void		u8g2_SetBufferCurrTileRow(u8g2_t *u8g2, uint8_t row);
+void		u8g2_SetAutoPageClear(u8g2_t *u8g2, uint8_t mode);
+void		u8g2_UpdateDisplayArea(u8g2_t *u8g2, uint8_t  tx, uint8_t ty, uint8_t tw, uint8_t th);
+void		u8g2_UpdateDisplay(u8g2_t *u8g2);
+
+void		u8g2_SetDrawColor(u8g2_t *u8g2, uint8_t color);
+uint8_t		u8g2_GetDrawColor(u8g2_t *u8g2);
+void		u8g2_DrawPixel(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y);
+void		u8g2_DrawHLine(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t len);
+void		u8g2_DrawVLine(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t len);
+void		u8g2_DrawHVLine(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t len, uint8_t dir);
+void		u8g2_DrawFrame(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h);
+void		u8g2_DrawRFrame(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, u8g2_uint_t r);
+void		u8g2_DrawBox(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h);
+void		u8g2_DrawRBox(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, u8g2_uint_t r);
+void		u8g2_DrawCircle(u8g2_t *u8g2, u8g2_uint_t x0, u8g2_uint_t y0, u8g2_uint_t rad, uint8_t option);
+void		u8g2_DrawDisc(u8g2_t *u8g2, u8g2_uint_t x0, u8g2_uint_t y0, u8g2_uint_t rad, uint8_t option);
+void		u8g2_DrawEllipse(u8g2_t *u8g2, u8g2_uint_t x0, u8g2_uint_t y0, u8g2_uint_t rx, u8g2_uint_t ry, uint8_t option);
+void		u8g2_DrawFilledEllipse(u8g2_t *u8g2, u8g2_uint_t x0, u8g2_uint_t y0, u8g2_uint_t rx, u8g2_uint_t ry, uint8_t option);
+void		u8g2_DrawLine(u8g2_t *u8g2, u8g2_uint_t x1, u8g2_uint_t y1, u8g2_uint_t x2, u8g2_uint_t y2);
+void		u8g2_SetBitmapMode(u8g2_t *u8g2, uint8_t is_transparent);
+void		u8g2_DrawBitmap(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t cnt, u8g2_uint_t h, const uint8_t *bitmap);
+void		u8g2_DrawXBM(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, const uint8_t *bitmap);
+void		u8g2_DrawXBMP(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, const uint8_t *bitmap);
+void		u8g2_DrawTriangle(u8g2_t *u8g2, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+void		u8g2_DrawLog(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8log_t *u8log);
+void		u8log_u8g2_cb(u8log_t * u8log);
+
+void		u8g2_SetFont(u8g2_t *u8g2, const uint8_t  *font);
+void		u8g2_SetFontMode(u8g2_t *u8g2, uint8_t is_transparent);
+void		u8g2_SetFontDirection(u8g2_t *u8g2, uint8_t dir);
+int8_t		u8g2_GetAscent(u8g2_t *u8g2);
+int8_t		u8g2_GetDescent(u8g2_t *u8g2);
+void		u8g2_SetFontPosBaseline(u8g2_t *u8g2);
+void		u8g2_SetFontPosBottom(u8g2_t *u8g2);
+void		u8g2_SetFontPosTop(u8g2_t *u8g2);
+void		u8g2_SetFontPosCenter(u8g2_t *u8g2);
+void		u8g2_SetFontRefHeightText(u8g2_t *u8g2);
+void		u8g2_SetFontRefHeightExtendedText(u8g2_t *u8g2);
+void		u8g2_SetFontRefHeightAll(u8g2_t *u8g2);
+int8_t		u8g2_GetMaxCharHeight(u8g2_t *u8g2);
+int8_t		u8g2_GetMaxCharWidth(u8g2_t *u8g2);
+u8g2_uint_t	u8g2_DrawGlyph(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, uint16_t encoding);
+u8g2_uint_t	u8g2_DrawStr(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, const char *str);
+u8g2_uint_t	u8g2_DrawUTF8(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, const char *str);
+u8g2_uint_t	u8g2_DrawExtUTF8(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, uint8_t to_left, const uint16_t *kerning_table, const char *str);
+u8g2_uint_t	u8g2_GetStrWidth(u8g2_t *u8g2, const char *s);
+u8g2_uint_t	u8g2_GetUTF8Width(u8g2_t *u8g2, const char *str);
+
+uint8_t		u8g2_UserInterfaceSelectionList(u8g2_t *u8g2, const char *title, uint8_t start_pos, const char *sl);
+uint8_t		u8g2_UserInterfaceMessage(u8g2_t *u8g2, const char *title1, const char *title2, const char *title3, const char *buttons);
+uint8_t		u8g2_UserInterfaceInputValue(u8g2_t *u8g2, const char *title, const char *pre, uint8_t *value, uint8_t lo, uint8_t hi, uint8_t digits, const char *post);
+
+// The fonts used by the controller, see display.cpp
+extern const uint8_t u8g_font_profont15r[];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U8G2_H */
@@ -0,0 +1,141 @@
+/*
+ * u8x8.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Host "digital twin" stand-in of the u8x8 part of the u8g2 library.
+ * All the functions referenced by myU8g2lib.h are declared, only the functions used by the controller are implemented.
+ */
+
+#ifndef U8X8_H
+#define U8X8_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define U8X8_MSG_GPIO_AND_DELAY_INIT	40
+#define U8X8_MSG_DELAY_NANO				44
+#define U8X8_MSG_DELAY_100NANO			43
+#define U8X8_MSG_DELAY_10MICRO			42
+#define U8X8_MSG_DELAY_MILLI			41
+#define U8X8_MSG_GPIO_DC				75
+#define U8X8_MSG_GPIO_CS				73
+#define U8X8_MSG_GPIO_RESET				75+1
+
+#define U8X8_MSG_BYTE_INIT				U8X8_MSG_CAD_INIT
+#define U8X8_MSG_BYTE_SET_DC			32
+#define U8X8_MSG_BYTE_SEND				U8X8_MSG_CAD_SEND_DATA
+#define U8X8_MSG_BYTE_START_TRANSFER	U8X8_MSG_CAD_START_TRANSFER
+#define U8X8_MSG_BYTE_END_TRANSFER		U8X8_MSG_CAD_END_TRANSFER
+#define U8X8_MSG_CAD_INIT				20
+#define U8X8_MSG_CAD_SEND_DATA			23
+#define U8X8_MSG_CAD_START_TRANSFER		24
+#define U8X8_MSG_CAD_END_TRANSFER		25
+
+typedef struct u8x8_struct			u8x8_t;
+typedef struct u8x8_display_info_struct u8x8_display_info_t;
+typedef struct u8log_struct			u8log_t;
+
+typedef uint8_t (*u8x8_msg_cb)(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr);
+typedef uint16_t (*u8x8_char_cb)(u8x8_t *u8x8, uint8_t b);
+typedef void (*u8log_cb)(u8log_t *u8log);
+
+struct u8x8_display_info_struct {
+	uint8_t		chip_enable_level;
+	uint8_t		chip_disable_level;
+	uint8_t		post_chip_enable_wait_ns;
+	uint8_t		pre_chip_disable_wait_ns;
+	uint8_t		reset_pulse_width_ms;
+	uint8_t		post_reset_wait_ms;
+	uint8_t		tile_width;
+	uint8_t		tile_height;
+	uint16_t	pixel_width;
+	uint16_t	pixel_height;
+};
+
+struct u8x8_struct {
+	const u8x8_display_info_t*	display_info;
+	u8x8_char_cb				next_cb;
+	u8x8_msg_cb					display_cb;
+	u8x8_msg_cb					cad_cb;
+	u8x8_msg_cb					byte_cb;
+	u8x8_msg_cb					gpio_and_delay_cb;
+	uint32_t					bus_clock;
+	uint8_t						is_font_inverse_mode;
+	uint8_t						i2c_address;
+	uint8_t						power_save;
+	uint8_t						flip_mode;
+	uint8_t						contrast;
+	uint16_t					encoding;
+	uint8_t						utf8_state;
+};
+
+struct u8log_struct {
+	u8log_cb	cb;
+	void*		aux_data;
+	uint8_t		width, height;
+	uint8_t*	screen_buffer;
+	uint8_t		cursor_x, cursor_y;
+	uint8_t		redraw_line;
+	uint8_t		redraw_line_for_each_char;
+	int8_t		line_height_offset;
+	uint8_t		is_redraw_all;
+	uint8_t		is_redraw_all_required_for_next_nl;
+};
+
+uint8_t		u8x8_GetCols(u8x8_t *u8x8);
+uint8_t		u8x8_GetRows(u8x8_t *u8x8);
+uint8_t		u8x8_DrawTile(u8x8_t *u8x8, uint8_t x, uint8_t y, uint8_t cnt, uint8_t *tile_ptr);
+void		u8x8_InitDisplay(u8x8_t *u8x8);
+void		u8x8_ClearDisplay(u8x8_t *u8x8);
+void		u8x8_FillDisplay(u8x8_t *u8x8);
+void		u8x8_SetPowerSave(u8x8_t *u8x8, uint8_t is_enable);
+void		u8x8_SetFlipMode(u8x8_t *u8x8, uint8_t mode);
+void		u8x8_RefreshDisplay(u8x8_t *u8x8);
+void		u8x8_ClearLine(u8x8_t *u8x8, uint8_t line);
+void		u8x8_SetContrast(u8x8_t *u8x8, uint8_t value);
+void		u8x8_SetInverseFont(u8x8_t *u8x8, uint8_t value);
+void		u8x8_SetFont(u8x8_t *u8x8, const uint8_t *font_8x8);
+void		u8x8_DrawGlyph(u8x8_t *u8x8, uint8_t x, uint8_t y, uint8_t encoding);
+void		u8x8_Draw2x2Glyph(u8x8_t *u8x8, uint8_t x, uint8_t y, uint8_t encoding);
+void		u8x8_Draw1x2Glyph(u8x8_t *u8x8, uint8_t x, uint8_t y, uint8_t encoding);
+uint8_t		u8x8_DrawString(u8x8_t *u8x8, uint8_t x, uint8_t y, const char *s);
+uint8_t		u8x8_DrawUTF8(u8x8_t *u8x8, uint8_t x, uint8_t y, const char *s);
+uint8_t		u8x8_Draw2x2String(u8x8_t *u8x8, uint8_t x, uint8_t y, const char *s);
+uint8_t		u8x8_Draw1x2String(u8x8_t *u8x8, uint8_t x, uint8_t y, const char *s);
+uint8_t		u8x8_Draw2x2UTF8(u8x8_t *u8x8, uint8_t x, uint8_t y, const char *s);
+uint8_t		u8x8_Draw1x2UTF8(u8x8_t *u8x8, uint8_t x, uint8_t y, const char *s);
+uint8_t		u8x8_GetUTF8Len(u8x8_t *u8x8, const char *s);
+uint8_t		u8x8_GetMenuEvent(u8x8_t *u8x8);
+uint8_t		u8x8_UserInterfaceSelectionList(u8x8_t *u8x8, const char *title, uint8_t start_pos, const char *sl);
+uint8_t		u8x8_UserInterfaceMessage(u8x8_t *u8x8, const char *title1, const char *title2, const char *title3, const char *buttons);
+uint8_t		u8x8_UserInterfaceInputValue(u8x8_t *u8x8, const char *title, const char *pre, uint8_t *value, uint8_t lo, uint8_t hi, uint8_t digits, const char *post);
+uint8_t		u8x8_cad_vsendf(u8x8_t * u8x8, const char *fmt, va_list va);
+void		u8x8_utf8_init(u8x8_t *u8x8);
+uint16_t	u8x8_ascii_next(u8x8_t *u8x8, uint8_t b);
+uint16_t	u8x8_utf8_next(u8x8_t *u8x8, uint8_t b);
+void		u8x8_DrawLog(u8x8_t *u8x8, uint8_t x, uint8_t y, u8log_t *u8log);
+
+void		u8log_Init(u8log_t *u8log, uint8_t width, uint8_t height, uint8_t *buf);
+void		u8log_SetCallback(u8log_t *u8log, u8log_cb cb, void *aux_data);
+void		u8log_SetRedrawMode(u8log_t *u8log, uint8_t is_redraw_line_for_each_char);
+void		u8log_SetLineHeightOffset(u8log_t *u8log, int8_t line_height_offset);
+void		u8log_WriteString(u8log_t *u8log, const char *s);
+void		u8log_WriteChar(u8log_t *u8log, uint8_t c);
+void		u8log_WriteHex8(u8log_t *u8log, uint8_t b);
+void		u8log_WriteHex16(u8log_t *u8log, uint16_t v);
+void		u8log_WriteHex32(u8log_t *u8log, uint32_t v);
+void		u8log_WriteDec8(u8log_t *u8log, uint8_t v, uint8_t d);
+void		u8log_WriteDec16(u8log_t *u8log, uint16_t v, uint8_t d);
+void		u8log_u8x8_cb(u8log_t * u8log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U8X8_H */
@@ -0,0 +1,37 @@
+/*
+ * at24c32.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include <string.h>
+#include "at24c32.h"
+
+void AT24C32::erase(void) {
+	memset(mem, 0xFF, sizeof(mem));
+	busy_till	= 0;
+	writes		= 0;
+	write_left	= no_loss;
+}
+
+bool AT24C32::read(uint64_t now, uint16_t addr, uint8_t* data, uint16_t size) {
+	if (!isReady(now)) return false;
+	for (uint16_t i = 0; i < size; ++i) {
+		data[i] = mem[(addr + i) & (this->size-1)];			// Sequential read rolls over the whole memory
+	}
+	return true;
+}
+
+bool AT24C32::write(uint64_t now, uint16_t addr, const uint8_t* data, uint16_t size) {
+	if (!isReady(now)) return false;
+	if (write_left == 0) return false;						// The power is lost
+	if (write_left != no_loss) --write_left;
+	addr &= this->size-1;
+	uint16_t p_start = addr & ~(page-1);					// The beginning of the page
+	for (uint16_t i = 0; i < size; ++i) {
+		mem[p_start + ((addr - p_start + i) & (page-1))] = data[i];	// Page write rolls over inside the page
+	}
+	busy_till = now + write_cycle;
+	++writes;
+	return true;
+}
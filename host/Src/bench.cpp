@@ -0,0 +1,340 @@
+/*
+ * bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * The control quality benchmark of the IRON PID on the host twin with the T12 thermal model (see plant.h)
+ * Usage: twin_bench [-g probability] [-w] [-a] [-s gain tau dead] [-t temp | -r | -b] [Kp Ki Kd]...
+ * Without PID parameters the default and the smooth PID parameter sets are benchmarked, see CFG_CORE::pidParams()
+ * -g	the probability of a corrupted IRON temperature conversion (noisy bench), see T12_PARAM::glitch
+ * -w	warm start: the controller boots with the EEPROM of the previous run of the same PID parameters,
+ * 		so the holding power model of the tip is learned already (see MWORK_IRON::learnHoldPower())
+ * -a	the adaptive PID: the PID follows the IRON model identified online, see MWORK_IRON::trackModel().
+ * 		With the warm start the identification starts by the model saved in the previous run
+ * -s	the PID parameters are saved as the tip ones with the IRON model and the Smith predictor is used, see PIDmodel and SMITH
+ * -t	the setpoint step to temp (Celsius) by the encoder instead of the load, see IRON::setTemp()
+ * -r	the re-entry instead of the load: the IRON is switched off (the standby mode) for a while, then it is switched on hot
+ * -b	the boost re-entry instead of the load: the boost mode is entered by the long press for a while, then the button returns
+ * 		to the working mode, see MBOOST
+ * twin_bench_v1 is the same benchmark built with the interactive PID formula (PID_V1), see pid.h
+ *
+ * The scenario: the controller boots at 25 Celsius, the IRON is switched on to reach preset temperature,
+ * then the solder joint load is applied for a while (or the event of -t, -r or -b happens at the same time).
+ * All the values are taken from the thermocouple temperature of the model.
+ *   rise		- the time to rise from 10% to 90% of the temperature step, s
+ *   overshoot	- the maximum temperature above the preset one before the load is applied, Celsius
+ *   settle		- the time since power on till the temperature stays inside the band, s
+ *   ready		- the time since power on till the controller shows 'Ready' message, s
+ *   ripple		- peak-to-peak temperature during the last seconds before the load is applied, Celsius
+ *   sag		- the maximum temperature drop below the preset one after the load is applied, Celsius
+ *   recovery	- the time since load applied till the temperature stays inside the band, s
+ * The event of -t, -r and -b is over when the user actions are done (the encoder is rotated, the button returns the working mode),
+ * then the temperature is compared with the preset one of the event:
+ *   over		- the maximum temperature above the preset one after the event, Celsius
+ *   under		- the maximum temperature below the preset one after the event, Celsius
+ *   settle		- the time since the event is over till the temperature stays inside the band, s
+ *   energy		- the energy consumed since power on till the load is applied, J
+ *   hold		- the average heater power to keep the preset temperature (before the load), W
+ *   power sd	- the standard deviation of the PID power in the ripple window, taken from the controller samples (adcSample())
+ *   pid, ns	- the host time of one PID::reqPower() call on the recorded temperature trace of the run
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "twin.h"
+#include "plant.h"
+#include "core.h"
+
+typedef struct s_bench_kpi	BENCH_KPI;
+struct s_bench_kpi {
+	double		rise;
+	double		overshoot;
+	double		settle;
+	double		ready;
+	double		ripple;
+	double		sag;										// under of the event
+	double		recovery;									// settle of the event
+	double		over;
+	double		energy;
+	double		hold;
+	double		power_sd;
+	double		pid_ns;
+};
+
+static const uint16_t	preset_temp		= 300;			// Celsius
+static const double		band			= 3.0;			// Settle band, Celsius
+static const uint32_t	load_start		= 60000;		// ms since power on
+static const uint32_t	load_time		= 5000;			// Load duration, ms
+static const uint32_t	run_time		= 120000;		// ms since power on
+static const uint32_t	ripple_time		= 10000;		// The ripple and hold power window before the load, ms
+static const double		load_g			= 0.15;			// Solder joint load, W/K
+static const uint32_t	standby_time	= 5000;			// The time the IRON is switched off, see -r
+static const uint32_t	boost_time		= 20000;		// The time in the boost mode, see -b
+static const uint8_t	boost_temp		= 50;			// The boost temperature increment, Celsius
+static PIDmodel			smith_model;					// The IRON model of the Smith predictor, see -s
+static bool				adapt			= false;		// The adaptive PID, see -a
+
+typedef enum { BENCH_LOAD = 0, BENCH_STEP, BENCH_STANDBY, BENCH_BOOST } BENCH_EVENT;
+static BENCH_EVENT		event			= BENCH_LOAD;
+static uint16_t			step_temp		= preset_temp;	// The preset temperature after the step, see -t
+
+/*
+ * Rotate the encoder to change the preset temperature by delta Celsius. The first step changes it by one,
+ * the next fast steps change it by 5, see RENC::encoderIntr(). The rest is entered by the slow steps
+ */
+static void encoderStep(int16_t delta) {
+	if (delta == 0) return;
+	int16_t		dir		= (delta > 0)?1:-1;
+	uint16_t	d		= abs(delta);
+	uint16_t	fast	= (d - 1) / 5;
+	twinEncoder(dir * (1 + fast));
+	for (uint16_t i = 1 + fast * 5; i < d; ++i) {
+		twinRun(400);										// Slow rotation
+		twinEncoder(dir);
+	}
+}
+
+/*
+ * The user actions of the event instead of the load, they take the twin time
+ * Returns the preset temperature after the event, Celsius
+ */
+static uint16_t benchEvent(void) {
+	switch (event) {
+		case BENCH_STEP:
+			encoderStep(step_temp - preset_temp);
+			return step_temp;
+		case BENCH_STANDBY:
+			twinButton(200);								// Switch the IRON off
+			twinRun(standby_time);
+			twinButton(200);								// Switch the hot IRON on
+			break;
+		case BENCH_BOOST:
+			twinButton(2000);								// The long press: the boost mode
+			twinRun(boost_time);
+			twinButton(200);								// Return to the working mode
+			break;
+		default:
+			break;
+	}
+	return preset_temp;
+}
+
+/*
+ * The PID engine cost: replay the temperature trace in a loop. The host time is not the CPU cycles of the controller,
+ * but it is fair to compare the engines built by the same compiler
+ */
+static double pidCost(const PIDparam& pp, const std::vector<int16_t>& trace) {
+	if (trace.empty()) return NAN;
+	PID pid;
+	pid.init();
+	pid.load(pp);
+	pid.powerLimits(0, 1956);
+	pid.model(smith_model, smith_model.isValid());
+	int16_t t_set = trace.back();							// The controller keeps the preset temperature at the end of the run
+	volatile int32_t sink = 0;
+	const uint8_t loops = 20;
+	auto start = std::chrono::steady_clock::now();
+	for (uint8_t l = 0; l < loops; ++l) {
+		pid.resetPID();
+		for (size_t i = 0; i < trace.size(); ++i)
+			sink = sink + pid.reqPower(t_set, trace[i], 8);
+	}
+	double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	return ns / ((double)loops * trace.size());
+}
+
+static uint8_t			eeprom_image[4096];				// The EEPROM content at the end of the last run
+
+static BENCH_KPI bench(const PIDparam& pp, double glitch, bool warm) {
+	BENCH_KPI kpi = {0};
+	TWIN_T12_PLANT plant;
+	T12_PARAM param = TWIN_T12_PLANT::def;
+	param.glitch = glitch;
+	plant.init(&param);
+	twinAttach(&plant);
+	twinReset();
+	if (warm) {
+		memcpy(twinEEPROM(), eeprom_image, sizeof(eeprom_image));
+	} else {
+		twinActivateTip(1);
+		twinPresetTemp(preset_temp);
+		twinPID(pp);
+		twinAdapt(adapt);
+		if (event == BENCH_BOOST)
+			twinBoost(boost_temp, 30);
+		if (smith_model.isValid())
+			twinTipPID(pp, smith_model, true);
+	}
+	twinBoot();
+	twinRun(1000);
+	twinPin(ENCODER_B_GPIO_Port, ENCODER_B_Pin, false);		// Press the button to switch the IRON on
+	twinRun(200);
+	twinPin(ENCODER_B_GPIO_Port, ENCODER_B_Pin, true);
+
+	double	t_start		= plant.sensorTemp();
+	double	t10			= t_start + (preset_temp - t_start) * 0.1;
+	double	t90			= t_start + (preset_temp - t_start) * 0.9;
+	double	e_start		= plant.energy();
+	double	e_hold		= 0;
+	double	r_min		= 1000, r_max = -1000;
+	int32_t	ms10		= -1, ms90 = -1;
+	int32_t	ms_ready	= -1;								// The time 'Ready' message appears on the screen
+	int32_t	out_before	= 0;								// Last time the temperature was outside the band before the load
+	int32_t	out_after	= load_start;						// Last time the temperature was outside the band after the load (event)
+	uint32_t event_end	= load_start;						// The time the event is over
+	uint16_t target		= preset_temp;						// The preset temperature after the event
+	bool	reached		= false;							// The temperature has reached the preset one of the event
+	bool	above		= false;							// The temperature is above the preset one when the event is over
+	double	p_sum		= 0, p_sum2 = 0;
+	uint32_t p_n		= 0;
+	std::vector<int16_t>	trace;							// The IRON temperature the PID was given, internal units
+	for (uint32_t ms = 0; ms < run_time; ++ms) {
+		if (ms == load_start - ripple_time)	e_hold = plant.energy();
+		if (ms == load_start) {
+			kpi.energy	= plant.energy() - e_start;
+			kpi.hold	= (plant.energy() - e_hold) * 1000.0 / ripple_time;
+		}
+		if (event == BENCH_LOAD) {
+			if (ms == load_start)				plant.load(load_g);
+			if (ms == load_start + load_time)	plant.load(0);
+		} else if (ms == load_start) {
+			uint64_t c_event = twinClocks();
+			target		= benchEvent();
+			ms			+= (twinClocks() - c_event) / (TWIN_CPU_CLOCK / 1000);	// The user actions take the twin time
+			event_end	= ms;
+			out_after	= ms;
+		}
+		twinRun(1);
+		ADC_SAMPLE s;
+		while (adcSample(&s)) {
+			trace.push_back(s.temp >> s.frac);
+			if (ms >= load_start - ripple_time && ms < load_start) {
+				p_sum	+= s.power;
+				p_sum2	+= (double)s.power * s.power;
+				++p_n;
+			}
+		}
+		if (ms_ready < 0 && twinFrameHas("Ready"))	ms_ready = ms;
+		double t	= plant.sensorTemp();
+		double err	= t - preset_temp;
+		if (ms < load_start) {
+			if (ms10 < 0 && t >= t10)	ms10 = ms;
+			if (ms90 < 0 && t >= t90)	ms90 = ms;
+			if (err > kpi.overshoot)	kpi.overshoot = err;
+			if (fabs(err) > band)		out_before = ms;
+			if (ms >= load_start - ripple_time) {
+				if (t < r_min) r_min = t;
+				if (t > r_max) r_max = t;
+			}
+		} else if (ms >= event_end) {
+			err = t - target;
+			if (fabs(err) > band)		out_after	= ms;
+			if (event != BENCH_LOAD && !reached) {			// The way to the preset temperature is not the undershoot or the overshoot
+				if (ms == event_end) above = err > 0;
+				reached = above?(err <= 0):(err >= 0);
+				if (!reached) continue;
+			}
+			if (-err > kpi.sag)			kpi.sag		= -err;
+			if (err > kpi.over)			kpi.over	= err;
+		}
+	}
+	kpi.rise		= (ms10 >= 0 && ms90 >= 0)?(ms90 - ms10) / 1000.0:NAN;
+	kpi.settle		= out_before / 1000.0;
+	kpi.ready		= (ms_ready >= 0)?ms_ready / 1000.0:NAN;
+	kpi.ripple		= r_max - r_min;
+	kpi.recovery	= (out_after - (int32_t)event_end) / 1000.0;
+	if (p_n) {
+		double avg		= p_sum / p_n;
+		kpi.power_sd	= sqrt(p_sum2 / p_n - avg * avg);
+	}
+	memcpy(eeprom_image, twinEEPROM(), sizeof(eeprom_image));
+	twinAttach(0);
+	kpi.pid_ns		= pidCost(pp, trace);
+	return kpi;
+}
+
+int main(int argc, char* argv[]) {
+	PIDparam	sets[8];
+	uint8_t		n = 0;
+	double		glitch = 0;
+	bool		warm = false;
+	int			arg = 1;
+	while (arg < argc && argv[arg][0] == '-') {
+		if (argv[arg][1] == 'g' && arg + 1 < argc) {
+			glitch = atof(argv[arg+1]);
+			arg += 2;
+		} else if (argv[arg][1] == 'w') {
+			warm = true;
+			++arg;
+		} else if (argv[arg][1] == 'a') {
+			adapt = true;
+			++arg;
+		} else if (argv[arg][1] == 't' && arg + 1 < argc) {
+			event		= BENCH_STEP;
+			step_temp	= atoi(argv[arg+1]);
+			arg += 2;
+		} else if (argv[arg][1] == 'r') {
+			event = BENCH_STANDBY;
+			++arg;
+		} else if (argv[arg][1] == 'b') {
+			event = BENCH_BOOST;
+			++arg;
+		} else if (argv[arg][1] == 's' && arg + 3 < argc) {
+			smith_model = PIDmodel(atoi(argv[arg+1]), atoi(argv[arg+2]), atoi(argv[arg+3]));
+			arg += 4;
+		} else {
+			break;
+		}
+	}
+	if (argc > arg) {
+		for (int i = arg; i + 2 < argc && n < 8; i += 3)
+			sets[n++] = PIDparam(atoi(argv[i]), atoi(argv[i+1]), atoi(argv[i+2]));
+	} else {
+		sets[n++] = PIDparam(2300, 48, 1700);				// CFG_CORE::setDefaults()
+		sets[n++] = PIDparam(575, 10, 200);					// CFG_CORE::pidParamsSmooth()
+	}
+
+	switch (event) {
+		case BENCH_STEP:
+			printf("Preset %d C, band +-%.0f C, the setpoint step to %d C at %.1f s, glitch probability %g%s\n", preset_temp, band, step_temp,
+				load_start / 1000.0, glitch, warm?", warm start":"");
+			break;
+		case BENCH_STANDBY:
+			printf("Preset %d C, band +-%.0f C, the IRON is switched off for %.1f s at %.1f s, glitch probability %g%s\n", preset_temp, band,
+				standby_time / 1000.0, load_start / 1000.0, glitch, warm?", warm start":"");
+			break;
+		case BENCH_BOOST:
+			printf("Preset %d C, band +-%.0f C, the boost +%d C for %.1f s at %.1f s, glitch probability %g%s\n", preset_temp, band, boost_temp,
+				boost_time / 1000.0, load_start / 1000.0, glitch, warm?", warm start":"");
+			break;
+		default:
+			printf("Preset %d C, band +-%.0f C, load %.2f W/K for %.1f s at %.1f s, glitch probability %g%s\n", preset_temp, band, load_g,
+				load_time / 1000.0, load_start / 1000.0, glitch, warm?", warm start":"");
+			break;
+	}
+	if (adapt)
+		printf("Adaptive PID\n");
+	if (smith_model.isValid())
+		printf("Smith predictor: gain %.2f, tau %d ms, dead time %d ms\n", smith_model.gain / 256.0, smith_model.tau, smith_model.dead);
+	if (event == BENCH_LOAD)
+		printf("   Kp    Ki    Kd | rise, s  overshoot, C  settle, s  ready, s  ripple, C | sag, C  recovery, s | energy, J  hold, W  power sd  pid, ns\n");
+	else
+		printf("   Kp    Ki    Kd | rise, s  overshoot, C  settle, s  ready, s  ripple, C | over, C  under, C  settle, s | energy, J  hold, W  power sd  pid, ns\n");
+	for (uint8_t i = 0; i < n; ++i) {
+		if (warm)
+			bench(sets[i], glitch, false);					// Learn the holding power model
+		BENCH_KPI k = bench(sets[i], glitch, warm);
+		printf("%5ld %5ld %5ld | %7.2f %12.1f %10.2f %8.2f %10.1f | ", (long)sets[i].Kp, (long)sets[i].Ki, (long)sets[i].Kd,
+			k.rise, k.overshoot, k.settle, k.ready, k.ripple);
+		if (event == BENCH_LOAD)
+			printf("%6.1f %12.2f | ", k.sag, k.recovery);
+		else
+			printf("%7.1f %8.1f %10.2f | ", k.over, k.sag, k.recovery);
+		printf("%9.0f %7.2f %9.1f %8.1f\n", k.energy, k.hold, k.power_sd, k.pid_ns);
+	}
+	return 0;
+}
@@ -0,0 +1,295 @@
+/*
+ * check.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * The host checks of the controller on the twin: the failure cases the benchmark does not run into.
+ * Usage: twin_check
+ * Each check prints its result, the exit code is the number of failed checks (see ctest)
+ *   dropout	- the heater current sense drops out for a while at the preset temperature (the heater contact),
+ *   			  the controller should resume heating when the current is back, see IRON_HW::isCurrentLost()
+ *   config63	- the newest configuration record is in the last chunk of the configuration area, saved before the chunk
+ *   			  was reserved for the PID gain schedule. It should be loaded and moved to the records, see EEPROM::init()
+ *   schedule	- a bit of the PID gain schedule is corrupted, the schedule should not be loaded, see EEPROM::SCHED_checkSum()
+ *   upgrade	- the first version tip area is upgraded, the power is lost after every number of the EEPROM writes,
+ *   			  then the upgrade runs again. Each tip should be kept once, see EEPROM::upgradeTipArea(). The tip area with
+ *   			  the free places is upgraded the same way: the converted records should not be moved to the free places
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stddef.h>
+#include "twin.h"
+#include "plant.h"
+#include "core.h"
+#include "config.h"
+#include "eeprom.h"
+
+extern I2C_HandleTypeDef	hi2c1;
+
+static const uint16_t	preset_temp		= 300;			// Celsius
+static const uint16_t	chunk			= 32;			// The EEPROM chunk size, see eeprom.h
+static const uint16_t	sched_chunk		= 63;			// The chunk of the PID gain schedule, see EEPROM
+
+static bool checkDropout(void) {
+	TWIN_T12_PLANT plant;
+	twinAttach(&plant);
+	twinReset();
+	twinActivateTip(1);
+	twinPresetTemp(preset_temp);
+	twinBoot();
+	twinRun(1000);
+	twinButton(200);										// Switch the IRON on
+	twinRun(60000);
+	double t_before = plant.sensorTemp();
+	plant.currentSense(false);
+	twinRun(500);
+	plant.currentSense(true);
+	twinRun(15000);
+	uint64_t on = twinHeaterOnClocks();
+	twinRun(5000);
+	double duty		= (double)(twinHeaterOnClocks() - on) * 100.0 / (5.0 * TWIN_CPU_CLOCK);
+	double t_after	= plant.sensorTemp();
+	twinAttach(0);
+	bool ok = fabs(t_after - preset_temp) < 5.0 && duty > 0;
+	printf("dropout: %.0f C before, %.0f C and %.1f%% duty 20 s after the 500 ms current dropout: %s\n",
+		t_before, t_after, duty, ok?"PASS":"FAIL");
+	return ok;
+}
+
+// The checksum of the configuration record, see EEPROM::CFG_checkSum()
+static uint16_t recordSum(RECORD* r) {
+	RECORD	c = *r;
+	c.crc	= 0;
+	uint16_t summ = 117;
+	uint8_t* d = (uint8_t*)&c;
+	for (uint8_t i = 0; i < sizeof(RECORD); ++i) {
+		summ <<= 1; summ += d[i];
+	}
+	return summ;
+}
+
+// The configuration records in the EEPROM with the given preset temperature
+static uint8_t recordsWithTemp(uint16_t temp) {
+	uint8_t n = 0;
+	for (uint16_t ch = 0; ch < sched_chunk; ++ch) {
+		RECORD* r = (RECORD*)(twinEEPROM() + ch * chunk);
+		if (r->crc == recordSum(r) && r->temp == temp) ++n;
+	}
+	return n;
+}
+
+static bool checkConfig63(void) {
+	const uint16_t last_temp = 320;
+	twinReset();
+	twinActivateTip(1);
+	twinPresetTemp(250);
+	RECORD newest = {0};
+	for (uint16_t ch = 0; ch < sched_chunk; ++ch) {
+		RECORD* r = (RECORD*)(twinEEPROM() + ch * chunk);
+		if (r->crc == recordSum(r) && r->ID > newest.ID) newest = *r;
+	}
+	newest.ID	+= 10;
+	newest.temp	= last_temp;
+	newest.crc	= recordSum(&newest);
+	memcpy(twinEEPROM() + sched_chunk * chunk, &newest, sizeof(RECORD));
+
+	bool ok = true;
+	for (uint8_t boot = 0; boot < 2; ++boot) {				// The record is moved once
+		CFG cfg(&hi2c1);
+		cfg.init();
+		ok = ok && cfg.tempPresetHuman() == last_temp && recordsWithTemp(last_temp) == 1;
+	}
+	printf("config63: the newest record in the schedule chunk is loaded and moved to the records: %s\n", ok?"PASS":"FAIL");
+	return ok;
+}
+
+// Every byte of the PID gain schedule is covered by the checksum: the corrupted schedule is not loaded
+static bool checkSchedule(void) {
+	twinReset();
+	EEPROM e(&hi2c1);
+	e.init();
+	PID_SCHEDULE s;
+	for (uint8_t i = 0; i < PID_BANDS; ++i) {
+		s.temp[i]	= 900 + i * 200;
+		s.Kp[i]		= 2300 - i * 100;
+		s.Ki[i]		= 48;
+		s.Kd[i]		= 1700;
+	}
+	bool ok = e.saveSchedule(&s) && e.loadSchedule(&s);
+	for (uint8_t i = 0; ok && i < offsetof(PID_SCHEDULE, crc); ++i) {
+		uint8_t* b = twinEEPROM() + sched_chunk * chunk + i;
+		*b ^= 0x01;
+		e.forceReloadChunk();
+		ok = !e.loadSchedule(&s);
+		*b ^= 0x01;
+	}
+	printf("schedule: the corrupted PID gain schedule is rejected: %s\n", ok?"PASS":"FAIL");
+	return ok;
+}
+
+// The first version tip record, see eeprom.cpp
+typedef struct s_tip_v1 TIP_V1;
+struct s_tip_v1 {
+	uint16_t	t200, t260, t330, t400;
+	uint8_t		mask;
+	char		name[tip_name_sz];
+	int8_t		ambient;
+	uint8_t		crc;
+};
+
+static const uint16_t	v1_places		= 128;			// The first version tip records in the tip area
+static const uint16_t	v2_places		= 64;
+
+static const uint16_t	crc2_place		= 37;			// The tip converted to the record that reads as the first version one
+static const uint8_t	v1_mask			= TIP_ACTIVE | TIP_CALIBRATED;
+
+// The tip area of the first version: every tenth place is free, so some records above 63 move to the free places
+static bool v1Tip(uint16_t k) {
+	return (k % 10) != 5;
+}
+
+// The checksum of the first version tip record, see isTipV1() in eeprom.cpp
+static uint8_t v1Sum(const TIP_V1* tip) {
+	uint32_t summ = tip->t200;
+	summ <<= 1; summ += tip->t260;
+	summ <<= 1; summ += tip->t330;
+	summ <<= 1; summ += tip->t400;
+	summ <<= 1; summ += tip->mask;
+	summ <<= 1; summ += tip->ambient;
+	for (uint8_t i = 0; i < tip_name_sz; ++i) {
+		summ <<= 1; summ += (uint8_t)tip->name[i];
+	}
+	return (summ + 117) & 0xFF;
+}
+
+// The first version tip record without the name and the checksum
+static void v1Record(uint16_t k, TIP_V1* tip) {
+	memset(tip, 0, sizeof(TIP_V1));
+	tip->t200		= 600 + k;
+	tip->t260		= 900;
+	tip->t330		= 1250;
+	tip->t400		= 1600;
+	tip->mask		= v1_mask | ((k & 0x3F) << 2);			// The holding power model in the upper bits
+	tip->ambient	= 25;
+}
+
+/*
+ * The tip name. The tip of crc2_place has the 5-char name: when its record is converted, the first version checksum
+ * of the chunk start is the record version (TIP_VERSION), so the converted chunk reads as the first version record
+ */
+static void v1Name(uint16_t k, char name[tip_name_sz]) {
+	memset(name, 0, tip_name_sz);
+	if (k != crc2_place) {
+		snprintf(name, tip_name_sz, "%c%02d", 'A' + k / 100, k % 100);
+		return;
+	}
+	for (uint16_t n = 0; n < 1000; ++n) {
+		char full[tip_name_sz+1];
+		snprintf(full, sizeof(full), "%c%c%u.%u", 'B' + n / 100, 'C' + n / 10 % 10, k % 10, n % 10);
+		TIP_V1 v2;											// The converted record read as the first version one
+		v1Record(k, &v2);
+		v2.mask = v1_mask;
+		memcpy(v2.name, full, tip_name_sz);
+		if (v1Sum(&v2) == TIP_VERSION) {
+			memcpy(name, full, tip_name_sz);
+			return;
+		}
+	}
+}
+
+static void v1Area(uint16_t tips) {
+	for (uint16_t k = 0; k < tips; ++k) {
+		if (!v1Tip(k)) continue;
+		TIP_V1 tip;
+		v1Record(k, &tip);
+		v1Name(k, tip.name);
+		tip.crc = v1Sum(&tip);
+		memcpy(twinEEPROM() + (v1_places / 2 + k / 2) * chunk + (k % 2) * sizeof(TIP_V1), &tip, sizeof(TIP_V1));
+	}
+}
+
+/*
+ * The tips kept after the upgrade: every tip of the first 64 places and the first tips above them moved to the free places.
+ * Returns the number of the tips lost or duplicated
+ */
+static uint16_t upgradeErrors(uint16_t tips) {
+	EEPROM	e(&hi2c1);
+	bool	kept[v1_places] = {false};
+	uint16_t errors = 0;
+	e.init();
+	for (uint8_t i = 0; i < v2_places; ++i) {
+		TIP tip;
+		if (e.loadTipData(&tip, i) != EPR_OK) continue;
+		uint16_t k = tip.t200 - 600;
+		char name[tip_name_sz];
+		v1Name(k, name);
+		if (k >= tips || kept[k] || memcmp(name, tip.name, tip_name_sz) != 0 || tip.hold != (k & 0x3F))
+			++errors;
+		else
+			kept[k] = true;
+	}
+	uint16_t free_places = 0;
+	for (uint16_t k = 0; k < v2_places; ++k) {
+		if (!v1Tip(k))		++free_places;
+		else if (k < tips && !kept[k])	++errors;
+	}
+	for (uint16_t k = v2_places; k < tips; ++k) {
+		if (!v1Tip(k)) continue;
+		if (free_places) {
+			--free_places;
+			if (!kept[k]) ++errors;
+		} else if (kept[k]) {
+			++errors;
+		}
+	}
+	return errors;
+}
+
+/*
+ * More than 64 tips: the power is lost while the records are moved (step 1) or converted (step 2).
+ * Less than 64 tips: the power is lost while the records are converted, some places are free. When the upgrade is repeated,
+ * step 1 reads the converted chunks again as the places above 63 of the first version. The converted record of crc2_place reads as
+ * the first version one there, it should not be moved to a free place
+ */
+static bool checkUpgrade(uint16_t tips) {
+	bool ok = true;
+	uint16_t runs = 0;
+	uint16_t total = 0;										// The tips converted by the complete upgrade
+	for (uint16_t k = 0; k < tips; ++k)
+		if (v1Tip(k)) ++total;
+	if (total > v2_places) total = v2_places;
+	for (uint32_t loss = 1; ; ++loss) {						// Till the upgrade is complete before the power loss
+		twinReset();
+		v1Area(tips);
+		twinEEPROMPowerLoss(loss);
+		EEPROM first(&hi2c1);
+		first.init();
+		uint8_t converted = first.upgradeTipArea();
+		twinEEPROMPowerOn();
+		EEPROM second(&hi2c1);
+		second.init();
+		second.upgradeTipArea();
+		uint16_t errors = upgradeErrors(tips);
+		if (errors) {
+			printf("upgrade: power loss after %lu writes, %u tips lost or duplicated\n", (unsigned long)loss, errors);
+			ok = false;
+		}
+		++runs;
+		if (converted == total) break;
+	}
+	printf("upgrade: the tip area of %u tips upgrade interrupted by the power loss (%u runs): %s\n", tips, runs, ok?"PASS":"FAIL");
+	return ok;
+}
+
+int main(int argc, char* argv[]) {
+	int failed = 0;
+	if (!checkDropout())	++failed;
+	if (!checkConfig63())	++failed;
+	if (!checkSchedule())	++failed;
+	if (!checkUpgrade(80))	++failed;
+	if (!checkUpgrade(40))	++failed;
+	return failed;
+}
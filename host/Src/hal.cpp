@@ -0,0 +1,611 @@
+/*
+ * hal.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * HAL stand-in of the host twin: peripheral emulation and the interrupt scheduler.
+ * The peripheral configuration mirrors the CubeMX generated code, see MX_*_Init() functions in main.c
+ */
+
+#include <string.h>
+#include <chrono>
+#include "twin.h"
+#include "at24c32.h"
+
+GPIO_TypeDef		twin_gpioa, twin_gpiob, twin_gpioc, twin_gpiod;
+TIM_TypeDef			twin_tim2, twin_tim4;
+ADC_TypeDef			twin_adc1, twin_adc2;
+SCB_Type			twin_scb;
+DWT_Type			twin_dwt;
+CoreDebug_Type		twin_coredebug;
+uint32_t			twin_basepri	= 0;
+
+// The peripheral handles are declared in main.c of the controller
+ADC_HandleTypeDef	hadc1;
+ADC_HandleTypeDef	hadc2;
+DMA_HandleTypeDef	hdma_adc1;
+I2C_HandleTypeDef	hi2c1;
+SPI_HandleTypeDef	hspi2;
+TIM_HandleTypeDef	htim2;
+TIM_HandleTypeDef	htim4;
+
+extern "C" void		EXTI0_IRQHandler(void);
+extern "C" void		PendSV_Handler(void);
+
+#define TIM_CR1_CEN		(0x0001U)
+#define TIM_DIER_CC3IE	(0x0008U)
+#define TIM_DIER_CC4IE	(0x0010U)
+#define TIM_DIER_CC2DE	(0x0400U)
+#define TIM_CCER_CC1E	(0x0001U)
+#define TIM_CCER_CC2E	(0x0010U)
+#define ADC_RANKS		(16)
+#define ADC_JRANKS		(4)
+#define EEPROM_ADDR		(0x50)
+
+typedef struct s_twin_adc	TWIN_ADC;
+struct s_twin_adc {
+	uint32_t	smp[ADC_RANKS];								// Sampling time of each regular rank
+	uint32_t	jrank[ADC_JRANKS];							// Channel number of each injected rank
+	uint32_t	jsmp[ADC_JRANKS];							// Sampling time of each injected rank
+	uint32_t	jnum;										// Number of injected conversions
+	uint32_t	jtrig;										// Injected group external trigger
+	uint16_t	jdr[ADC_JRANKS];							// Injected data registers
+	bool		on;
+	bool		jon;										// Injected group is started
+	bool		jit;										// Injected end of conversion interrupt is enabled
+};
+
+static uint64_t				now				= 0;			// CPU clocks since reset
+static uint64_t				tim2_next		= 0;			// The time when TIM2 counter should be incremented
+static uint32_t				tim2_ccr1		= 0;			// Active (shadow) value of CCR1, loaded on update event
+static uint32_t				tim2_arr		= 0;			// Active (shadow) value of ARR, loaded on update event when ARPE is set
+static uint64_t				heater_on		= 0;			// CPU clocks the IRON was powered
+static uint64_t				dma_done		= 0;			// The time when the regular sequence conversion completes, 0 if idle
+static uint32_t*			dma_data		= 0;
+static uint32_t				dma_len			= 0;
+static uint32_t				dma_pos			= 0;			// The number of words transfered
+static bool					dma_armed		= false;		// The DMA is started and waits for the regular group conversions
+static bool					dma_circular	= false;		// The DMA transfer restarts from the buffer beginning when complete
+static uint64_t				jeoc_done		= 0;			// The time when the injected sequence conversion completes, 0 if idle
+static uint16_t*			cc2_data		= 0;			// TIM2 CH2 DMA: the compare values loaded to CCR2 on each compare event (circular)
+static uint16_t				cc2_len			= 0;
+static uint16_t				cc2_pos			= 0;
+static TWIN_ADC				adc[2];
+static TWIN_PLANT*			plant			= 0;
+static AT24C32				eeprom;
+static TWIN_ISR_STAT		isr_stat[TWIN_ISR_NUM];
+static TWIN_STATIC_PLANT	default_plant;
+static bool					isr_active		= false;		// An interrupt handler is running
+static std::chrono::steady_clock::time_point isr_start;		// Host time when the running interrupt handler started
+
+//---------------------- The interrupt handler call with host time accounting ----
+static std::chrono::steady_clock::time_point isrBegin(void) {
+	isr_active	= true;
+	isr_start	= std::chrono::steady_clock::now();
+	return isr_start;
+}
+
+static void isrEnter(TWIN_ISR isr, std::chrono::steady_clock::time_point start) {
+	isr_active	= false;
+	uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	TWIN_ISR_STAT* s = &isr_stat[isr];
+	++s->calls;
+	s->total_ns += ns;
+	if (ns > s->max_ns) s->max_ns = ns;
+}
+
+// The PendSV exception has the lowest priority, it is served when all the other handlers are complete and it is not masked
+static void pendSV(void) {
+	if (!(twin_scb.ICSR & SCB_ICSR_PENDSVSET_Msk)) return;
+	if (twin_basepri && twin_basepri <= (15U << (8 - __NVIC_PRIO_BITS))) return;	// See HAL_MspInit()
+	twin_scb.ICSR &= ~SCB_ICSR_PENDSVSET_Msk;
+	std::chrono::steady_clock::time_point start = isrBegin();
+	PendSV_Handler();
+	isrEnter(TWIN_ISR_PENDSV, start);
+}
+
+static void tim2CompareIRQ(HAL_TIM_ActiveChannel channel) {
+	std::chrono::steady_clock::time_point start = isrBegin();
+	htim2.Channel = channel;
+	HAL_TIM_OC_DelayElapsedCallback(&htim2);
+	htim2.Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+	isrEnter(TWIN_ISR_TIM2, start);
+}
+
+static bool ironPowered(void) {
+	return (TIM2->CR1 & TIM_CR1_CEN) && (TIM2->CCER & TIM_CCER_CC1E) && (TIM2->CNT < tim2_ccr1);
+}
+
+// The channel of the regular rank (0-based) is read from the sequence registers, the controller can rewrite them on the fly
+static uint32_t sqrChannel(ADC_TypeDef* a, uint32_t r) {
+	if (r < 6)	return (a->SQR3 >> (5*r)) & 0x1F;
+	if (r < 12)	return (a->SQR2 >> (5*(r-6))) & 0x1F;
+	return (a->SQR1 >> (5*(r-12))) & 0x1F;
+}
+
+static uint32_t regularRanks(void) {
+	uint32_t ranks = hadc1.Init.NbrOfConversion;
+	if (ranks == 0 || ranks > ADC_RANKS) ranks = 1;
+	return ranks;
+}
+
+// One conversion time in CPU clocks: sampling time + 12.5 ADC clocks
+static uint32_t convClocks(uint32_t smp) {
+	static const uint16_t half_cycles[8] = { 3, 15, 27, 57, 83, 111, 143, 479 };	// ADC_SAMPLETIME_1CYCLE_5 ... ADC_SAMPLETIME_239CYCLES_5
+	return (half_cycles[smp & 7] + 25) * TWIN_ADC_CLK_DIV / 2;
+}
+
+// Start the regular sequence conversion by the trigger event. Both ADCs use the same sampling time in simultaneous mode
+static void regularTrigger(void) {
+	if (dma_armed && !dma_done) {
+		uint64_t clocks = 0;
+		for (uint32_t r = 0; r < regularRanks(); ++r)
+			clocks += convClocks(adc[0].smp[r]);
+		dma_done = now + clocks;
+	}
+}
+
+// Dual regular simultaneous mode: ADC1 data in the lower half-word, ADC2 data in the upper half-word
+static void dmaComplete(void) {
+	uint32_t ranks = regularRanks();
+	bool powered = ironPowered();
+	for (uint32_t r = 0; r < ranks && dma_pos < dma_len; ++r) {
+		uint32_t a1 = plant->adc(sqrChannel(ADC1, r), powered) & 0xFFF;
+		uint32_t a2 = 0;
+		if (adc[1].on)
+			a2 = plant->adc(sqrChannel(ADC2, r), powered) & 0xFFF;
+		dma_data[dma_pos++] = a1 | (a2 << 16);
+	}
+	dma_done = 0;
+	bool half = (dma_pos >= dma_len / 2) && (dma_pos - ranks < dma_len / 2);	// Half transfer just passed
+	bool full = (dma_pos >= dma_len);
+	if (full) {
+		dma_pos		= 0;
+		dma_armed	= dma_circular;							// DMA_NORMAL mode: the transfer is complete
+	}
+	if (hadc1.Init.ExternalTrigConv == ADC_SOFTWARE_START && dma_armed)
+		regularTrigger();
+	if (half || full) {
+		std::chrono::steady_clock::time_point start = isrBegin();
+		if (full)
+			HAL_ADC_ConvCpltCallback(&hadc1);
+		else
+			HAL_ADC_ConvHalfCpltCallback(&hadc1);
+		isrEnter(TWIN_ISR_ADC, start);
+	}
+}
+
+// Start the injected sequence conversion of both ADCs by the trigger event (dual injected simultaneous mode)
+static void injectedTrigger(void) {
+	if (adc[0].jon && !jeoc_done) {
+		uint64_t clocks = 0;
+		for (uint32_t r = 0; r < adc[0].jnum; ++r)
+			clocks += convClocks(adc[0].jsmp[r]);
+		jeoc_done = now + clocks;
+	}
+}
+
+static void injectedComplete(void) {
+	bool powered = ironPowered();
+	for (uint8_t i = 0; i < 2; ++i) {
+		if (!adc[i].jon) continue;
+		for (uint32_t r = 0; r < adc[i].jnum; ++r)
+			adc[i].jdr[r] = plant->adc(adc[i].jrank[r], powered) & 0xFFF;
+	}
+	jeoc_done = 0;
+	if (!adc[0].jit) return;
+	std::chrono::steady_clock::time_point start = isrBegin();
+	HAL_ADCEx_InjectedConvCpltCallback(&hadc1);
+	isrEnter(TWIN_ISR_JADC, start);
+}
+
+// The TIM2 counter increment: update event on overflow, then compare events and ADC triggers
+static void tim2Tick(void) {
+	tim2_next += TIM2->PSC + 1;
+	if (!(TIM2->CR1 & TIM_CR1_CEN)) return;
+	uint32_t arr = (TIM2->CR1 & TIM_CR1_ARPE)?tim2_arr:TIM2->ARR;
+	if (++TIM2->CNT > arr) {
+		TIM2->CNT	= 0;
+		tim2_ccr1	= TIM2->CCR1;							// The PWM channel has preload enabled (HAL_TIM_PWM_ConfigChannel)
+		tim2_arr	= TIM2->ARR;
+	}
+	if ((TIM2->DIER & TIM_DIER_CC3IE) && TIM2->CNT == TIM2->CCR3)
+		tim2CompareIRQ(HAL_TIM_ACTIVE_CHANNEL_3);
+	if ((TIM2->DIER & TIM_DIER_CC4IE) && TIM2->CNT == TIM2->CCR4)
+		tim2CompareIRQ(HAL_TIM_ACTIVE_CHANNEL_4);
+	// TRGO rising edge of OC3REF in PWM mode 2
+	if ((TIM2->CR2 & TIM_CR2_MMS) == TIM_TRGO_OC3REF && TIM2->CNT == TIM2->CCR3 && adc[0].jtrig == ADC_EXTERNALTRIGINJECCONV_T2_TRGO)
+		injectedTrigger();
+	if (TIM2->CNT == TIM2->CCR2) {
+		if ((TIM2->CCER & TIM_CCER_CC2E) && hadc1.Init.ExternalTrigConv == ADC_EXTERNALTRIGCONV_T2_CC2)
+			regularTrigger();
+		if ((TIM2->DIER & TIM_DIER_CC2DE) && cc2_data) {	// The DMA request loads the next compare value
+			TIM2->CCR2 = cc2_data[cc2_pos];
+			if (++cc2_pos >= cc2_len) cc2_pos = 0;
+		}
+	}
+}
+
+//---------------------- Low level twin functions --------------------------------
+// The peripheral configuration, see MX_ADC1_Init(), MX_ADC2_Init(), MX_TIM2_Init() and MX_TIM4_Init() in main.c
+static void boardInit(void) {
+	ADC_ChannelConfTypeDef		sConfig = {0};
+	ADC_InjectionConfTypeDef	sConfigInjected = {0};
+
+	hadc1.Instance					= ADC1;
+	hadc1.Init.NbrOfConversion		= 16;
+	hadc1.Init.ExternalTrigConv		= ADC_EXTERNALTRIGCONV_T2_CC2;
+	hadc1.DMA_Handle				= &hdma_adc1;
+	hdma_adc1.Init.Mode				= DMA_CIRCULAR;			// HAL_ADC_MspInit()
+	hadc2.Instance					= ADC2;
+	hadc2.Init.NbrOfConversion		= 16;
+	hadc2.Init.ExternalTrigConv		= ADC_SOFTWARE_START;
+	sConfig.SamplingTime			= ADC_SAMPLETIME_28CYCLES_5;
+	for (uint32_t r = 0; r < 16; ++r) {						// Both ADCs sample IRON_TEMP and AMBIENT in turn
+		sConfig.Rank	= ADC_REGULAR_RANK_1 + r;
+		sConfig.Channel	= (r & 1)?ADC_CHANNEL_4:ADC_CHANNEL_6;
+		HAL_ADC_ConfigChannel(&hadc1, &sConfig);
+		sConfig.Channel	= (r & 1)?ADC_CHANNEL_6:ADC_CHANNEL_4;
+		HAL_ADC_ConfigChannel(&hadc2, &sConfig);
+	}
+	sConfigInjected.InjectedNbrOfConversion	= 2;
+	sConfigInjected.InjectedSamplingTime	= ADC_SAMPLETIME_71CYCLES_5;
+	sConfigInjected.ExternalTrigInjecConv	= ADC_EXTERNALTRIGINJECCONV_T2_TRGO;
+	sConfigInjected.InjectedChannel = ADC_CHANNEL_2;	sConfigInjected.InjectedRank = ADC_INJECTED_RANK_1;
+	HAL_ADCEx_InjectedConfigChannel(&hadc1, &sConfigInjected);
+	sConfigInjected.InjectedChannel = ADC_CHANNEL_2;	sConfigInjected.InjectedRank = ADC_INJECTED_RANK_2;
+	HAL_ADCEx_InjectedConfigChannel(&hadc1, &sConfigInjected);
+	sConfigInjected.ExternalTrigInjecConv	= ADC_INJECTED_SOFTWARE_START;
+	sConfigInjected.InjectedChannel = ADC_CHANNEL_4;	sConfigInjected.InjectedRank = ADC_INJECTED_RANK_1;
+	HAL_ADCEx_InjectedConfigChannel(&hadc2, &sConfigInjected);
+	sConfigInjected.InjectedChannel = ADC_CHANNEL_4;	sConfigInjected.InjectedRank = ADC_INJECTED_RANK_2;
+	HAL_ADCEx_InjectedConfigChannel(&hadc2, &sConfigInjected);
+
+	htim2.Instance					= TIM2;
+	htim2.Init.Prescaler			= 749;
+	htim2.Init.Period				= 1999;
+	TIM2->PSC						= htim2.Init.Prescaler;
+	TIM2->ARR						= htim2.Init.Period;
+	TIM2->CR1						= TIM_CR1_ARPE;			// htim2.Init.AutoReloadPreload
+	tim2_arr						= TIM2->ARR;
+	TIM2->CR2						= TIM_TRGO_OC3REF;		// HAL_TIMEx_MasterConfigSynchronization()
+	TIM2->CCR2						= 1980;
+	TIM2->CCR3						= 1;
+	htim4.Instance					= TIM4;
+	htim4.Init.Prescaler			= 71;
+	htim4.Init.Period				= 65535;
+	TIM4->PSC						= htim4.Init.Prescaler;
+	TIM4->ARR						= htim4.Init.Period;
+}
+
+void twinReset(void) {
+	now			= 0;
+	tim2_next	= 0;
+	tim2_ccr1	= 0;
+	tim2_arr	= 0;
+	heater_on	= 0;
+	dma_done	= 0;
+	dma_data	= 0;
+	dma_len		= 0;
+	dma_pos		= 0;
+	dma_armed	= false;
+	dma_circular= false;
+	jeoc_done	= 0;
+	cc2_data	= 0;
+	cc2_len		= 0;
+	cc2_pos		= 0;
+	memset(adc, 0, sizeof(adc));
+	memset(&twin_tim2, 0, sizeof(TIM_TypeDef));
+	memset(&twin_tim4, 0, sizeof(TIM_TypeDef));
+	memset(&twin_adc1, 0, sizeof(ADC_TypeDef));
+	memset(&twin_adc2, 0, sizeof(ADC_TypeDef));
+	memset(&twin_scb, 0, sizeof(SCB_Type));
+	memset(&twin_dwt, 0, sizeof(DWT_Type));
+	memset(&twin_coredebug, 0, sizeof(CoreDebug_Type));
+	twin_basepri	= 0;
+	GPIO_TypeDef* ports[4] = { GPIOA, GPIOB, GPIOC, GPIOD };
+	for (uint8_t i = 0; i < 4; ++i) {
+		memset(ports[i], 0, sizeof(GPIO_TypeDef));
+		ports[i]->IDR = 0xFFFF;								// All inputs are pulled up
+	}
+	eeprom.erase();
+	eeprom.connect(true);
+	if (!plant) plant = &default_plant;
+	twinIsrStatReset();
+	boardInit();
+}
+
+void twinAttach(TWIN_PLANT* p) {
+	plant = p?p:&default_plant;
+}
+
+uint64_t twinClocks(void) {
+	return now;
+}
+
+void twinAdvance(uint64_t clocks) {
+	if (!plant) plant = &default_plant;
+	uint64_t till = now + clocks;
+	while (now < till) {
+		uint64_t next = till;
+		if (tim2_next < next) next = tim2_next;
+		if (dma_done && dma_done < next) next = dma_done;
+		if (jeoc_done && jeoc_done < next) next = jeoc_done;
+		bool powered = ironPowered();
+		if (next > now) {
+			plant->heater(powered, next - now);
+			if (powered) heater_on += next - now;
+			now = next;
+		}
+		if (dma_done && now >= dma_done)
+			dmaComplete();
+		if (jeoc_done && now >= jeoc_done)
+			injectedComplete();
+		if (now >= tim2_next)
+			tim2Tick();
+		pendSV();
+	}
+}
+
+void twinPin(GPIO_TypeDef* port, uint16_t pin, bool high) {
+	if (high)
+		port->IDR |= pin;
+	else
+		port->IDR &= ~pin;
+}
+
+uint8_t* twinEEPROM(void) {
+	return eeprom.memory();
+}
+
+void twinEEPROMConnected(bool connected) {
+	eeprom.connect(connected);
+}
+
+void twinEEPROMPowerLoss(uint32_t writes) {
+	eeprom.powerLoss(writes);
+}
+
+void twinEEPROMPowerOn(void) {
+	eeprom.powerOn();
+}
+
+uint64_t twinHeaterOnClocks(void) {
+	return heater_on;
+}
+
+/*
+ * The twin time does not advance inside the interrupt handler,
+ * so the cycle counter adds the host time spent in the running handler scaled to the CPU clock
+ */
+DWT_Type* twinDWT(void) {
+	if (twin_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) {
+		uint64_t clocks = now;
+		if (isr_active) {
+			uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - isr_start).count();
+			clocks += ns * (TWIN_CPU_CLOCK / 1000000UL) / 1000;
+		}
+		twin_dwt.CYCCNT = (uint32_t)clocks;
+	}
+	return &twin_dwt;
+}
+
+const TWIN_ISR_STAT* twinIsrStat(TWIN_ISR isr) {
+	if (isr >= TWIN_ISR_NUM) return 0;
+	return &isr_stat[isr];
+}
+
+void twinIsrStatReset(void) {
+	memset(isr_stat, 0, sizeof(isr_stat));
+}
+
+void twinExtiIRQ(void) {
+	std::chrono::steady_clock::time_point start = isrBegin();
+	EXTI0_IRQHandler();
+	isrEnter(TWIN_ISR_EXTI, start);
+	pendSV();
+}
+
+void TWIN_STATIC_PLANT::set(uint16_t temp, uint16_t current, uint16_t ambient) {
+	t_iron	= temp;
+	c_iron	= current;
+	t_amb	= ambient;
+}
+
+uint16_t TWIN_STATIC_PLANT::adc(uint32_t channel, bool heater_on) {
+	switch (channel) {
+		case ADC_CHANNEL_2:									// IRON_CURRENT_Pin
+			return heater_on?c_iron:0;
+		case ADC_CHANNEL_4:									// IRON_TEMP_Pin
+			return t_iron;
+		case ADC_CHANNEL_6:									// AMBIENT_Pin
+			return t_amb;
+		default:
+			break;
+	}
+	return 0;
+}
+
+//---------------------- HAL entry points ----------------------------------------
+extern "C" {
+
+uint32_t HAL_GetTick(void) {
+	return now / (TWIN_CPU_CLOCK / 1000);
+}
+
+// The hardware keeps running during the delay
+void HAL_Delay(uint32_t Delay) {
+	twinAdvance((uint64_t)Delay * (TWIN_CPU_CLOCK / 1000));
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin) {
+	return (GPIOx->IDR & GPIO_Pin)?GPIO_PIN_SET:GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+	if (PinState == GPIO_PIN_SET)
+		GPIOx->ODR |= GPIO_Pin;
+	else
+		GPIOx->ODR &= ~GPIO_Pin;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel) {
+	htim->Instance->CCER |= TIM_CCER_CC1E << Channel;
+	htim->Instance->CR1	 |= TIM_CR1_CEN;
+	if (htim->Instance == TIM2 && tim2_next < now)
+		tim2_next = now;
+	return HAL_OK;
+}
+
+// The weak callbacks of the HAL driver
+__attribute__((weak)) void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim) { }
+__attribute__((weak)) void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc) { }
+
+HAL_StatusTypeDef HAL_TIM_OC_Start(TIM_HandleTypeDef *htim, uint32_t Channel) {
+	htim->Instance->CCER |= TIM_CCER_CC1E << Channel;
+	htim->Instance->CR1	 |= TIM_CR1_CEN;
+	if (htim->Instance == TIM2 && tim2_next < now)
+		tim2_next = now;
+	return HAL_OK;
+}
+
+// Only TIM2 CH2 DMA is emulated: DMA_CIRCULAR, halfword alignment, see HAL_TIM_Base_MspInit()
+HAL_StatusTypeDef HAL_TIM_OC_Start_DMA(TIM_HandleTypeDef *htim, uint32_t Channel, uint32_t *pData, uint16_t Length) {
+	if (htim->Instance != TIM2 || Channel != TIM_CHANNEL_2 || !pData || Length == 0) return HAL_ERROR;
+	cc2_data	= (uint16_t*)pData;
+	cc2_len		= Length;
+	cc2_pos		= 0;
+	htim->Instance->DIER |= TIM_DIER_CC2DE;
+	return HAL_TIM_OC_Start(htim, Channel);
+}
+
+HAL_StatusTypeDef HAL_TIM_OC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel) {
+	htim->Instance->DIER |= 0x0002U << (Channel >> 2);		// CCxIE bit
+	htim->Instance->CCER |= TIM_CCER_CC1E << Channel;
+	htim->Instance->CR1	 |= TIM_CR1_CEN;
+	if (htim->Instance == TIM2 && tim2_next < now)
+		tim2_next = now;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef* hadc, ADC_ChannelConfTypeDef* sConfig) {
+	TWIN_ADC* a = (hadc->Instance == ADC1)?&adc[0]:&adc[1];
+	if (sConfig->Rank < 1 || sConfig->Rank > ADC_RANKS) return HAL_ERROR;
+	uint32_t r		= sConfig->Rank-1;
+	__IO uint32_t* sqr	= (r < 6)?&hadc->Instance->SQR3:((r < 12)?&hadc->Instance->SQR2:&hadc->Instance->SQR1);
+	uint32_t shift	= 5 * (r % 6);
+	*sqr			= (*sqr & ~(0x1FU << shift)) | ((sConfig->Channel & 0x1F) << shift);
+	a->smp[r]		= sConfig->SamplingTime;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start(ADC_HandleTypeDef* hadc) {
+	TWIN_ADC* a = (hadc->Instance == ADC1)?&adc[0]:&adc[1];
+	a->on = true;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Stop(ADC_HandleTypeDef* hadc) {
+	TWIN_ADC* a = (hadc->Instance == ADC1)?&adc[0]:&adc[1];
+	a->on = false;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef* hadc) {
+	return HAL_OK;
+}
+
+// The conversion starts immediately in case of software start, otherwise it waits for the trigger event
+HAL_StatusTypeDef HAL_ADCEx_MultiModeStart_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length) {
+	if (dma_armed) return HAL_BUSY;
+	adc[0].on	= true;
+	dma_data	= pData;
+	dma_len		= Length;
+	dma_pos		= 0;
+	dma_armed	= true;
+	dma_circular= hadc->DMA_Handle && hadc->DMA_Handle->Init.Mode == DMA_CIRCULAR;
+	if (hadc->Init.ExternalTrigConv == ADC_SOFTWARE_START)
+		regularTrigger();
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_MultiModeStop_DMA(ADC_HandleTypeDef *hadc) {
+	adc[0].on	= false;
+	dma_armed	= false;
+	dma_done	= 0;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_InjectedConfigChannel(ADC_HandleTypeDef* hadc, ADC_InjectionConfTypeDef* sConfigInjected) {
+	TWIN_ADC* a = (hadc->Instance == ADC1)?&adc[0]:&adc[1];
+	if (sConfigInjected->InjectedRank < 1 || sConfigInjected->InjectedRank > ADC_JRANKS) return HAL_ERROR;
+	if (sConfigInjected->InjectedNbrOfConversion < 1 || sConfigInjected->InjectedNbrOfConversion > ADC_JRANKS) return HAL_ERROR;
+	a->jrank[sConfigInjected->InjectedRank-1]	= sConfigInjected->InjectedChannel;
+	a->jsmp[sConfigInjected->InjectedRank-1]	= sConfigInjected->InjectedSamplingTime;
+	a->jnum		= sConfigInjected->InjectedNbrOfConversion;
+	a->jtrig	= sConfigInjected->ExternalTrigInjecConv;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_InjectedStart(ADC_HandleTypeDef* hadc) {
+	TWIN_ADC* a = (hadc->Instance == ADC1)?&adc[0]:&adc[1];
+	a->jon = true;
+	if (a->jtrig == ADC_INJECTED_SOFTWARE_START && a == &adc[0])
+		injectedTrigger();
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_InjectedStart_IT(ADC_HandleTypeDef* hadc) {
+	TWIN_ADC* a = (hadc->Instance == ADC1)?&adc[0]:&adc[1];
+	a->jit = true;
+	return HAL_ADCEx_InjectedStart(hadc);
+}
+
+HAL_StatusTypeDef HAL_ADCEx_InjectedStop(ADC_HandleTypeDef* hadc) {
+	TWIN_ADC* a = (hadc->Instance == ADC1)?&adc[0]:&adc[1];
+	a->jon = false;
+	if (a == &adc[0]) jeoc_done = 0;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_InjectedStop_IT(ADC_HandleTypeDef* hadc) {
+	TWIN_ADC* a = (hadc->Instance == ADC1)?&adc[0]:&adc[1];
+	a->jit = false;
+	return HAL_ADCEx_InjectedStop(hadc);
+}
+
+uint32_t HAL_ADCEx_InjectedGetValue(ADC_HandleTypeDef* hadc, uint32_t InjectedRank) {
+	TWIN_ADC* a = (hadc->Instance == ADC1)?&adc[0]:&adc[1];
+	if (InjectedRank < 1 || InjectedRank > ADC_JRANKS) return 0;
+	return a->jdr[InjectedRank-1];
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout) {
+	if ((DevAddress >> 1) == EEPROM_ADDR && eeprom.isReady(now))
+		return HAL_OK;
+	return HAL_ERROR;										// The display is connected to the SPI bus
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+	if ((DevAddress >> 1) != EEPROM_ADDR) return HAL_ERROR;
+	return eeprom.write(now, MemAddress, pData, Size)?HAL_OK:HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+	if ((DevAddress >> 1) != EEPROM_ADDR) return HAL_ERROR;
+	return eeprom.read(now, MemAddress, pData, Size)?HAL_OK:HAL_ERROR;
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c) {
+	return HAL_I2C_STATE_READY;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+	return HAL_OK;
+}
+
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi) {
+	return HAL_SPI_STATE_READY;
+}
+
+}
@@ -0,0 +1,132 @@
+/*
+ * plant.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include <math.h>
+#include "plant.h"
+
+// The typical T12 cartridge powered by 24 volts: about 10 seconds to heat up to 300 Celsius, 8 watts to keep 235 Celsius
+const T12_PARAM TWIN_T12_PLANT::def = {
+	24.0,													// voltage
+	8.0,													// resistance
+	0.4,													// c_heater
+	2.0,													// c_tip
+	1.5,													// g_ht
+	0.005,													// g_ha
+	0.035,													// g_ta
+	0.3,													// tc_lag
+	25e-6,													// tc_settle
+	1.5,													// noise
+	0,														// glitch
+	1500													// current
+};
+
+// Default tip calibration: the reference temperatures and internal readings, see TIP_CFG::defaultCalibration()
+static const double	cal_temp[4]	= { 200, 260, 330, 400 };
+static const double	cal_adc[4]	= { 680, 964, 1290, 1600 };
+
+TWIN_T12_PLANT::TWIN_T12_PLANT(void) {
+	init(&def);
+}
+
+void TWIN_T12_PLANT::init(const T12_PARAM* param, double ambient) {
+	p			= *param;
+	p_max		= p.voltage * p.voltage / p.resistance;
+	t_a			= t_h = t_t = t_s = ambient;
+	g_load		= 0;
+	e_j			= 0;
+	off_time	= 1.0;
+	connected	= true;
+	c_sense		= true;
+	seed		= 1;
+}
+
+void TWIN_T12_PLANT::heater(bool on, uint32_t clocks) {
+	double dt	= (double)clocks / TWIN_CPU_CLOCK;
+	double pwr	= (on && connected)?p_max:0;
+	double q_ht	= p.g_ht * (t_h - t_t);
+	double d_h	= (pwr - q_ht - p.g_ha * (t_h - t_a)) / p.c_heater;
+	double d_t	= (q_ht - (p.g_ta + g_load) * (t_t - t_a)) / p.c_tip;
+	t_h		   += d_h * dt;
+	t_t		   += d_t * dt;
+	t_s		   += (t_h - t_s) * dt / (p.tc_lag + dt);
+	e_j		   += pwr * dt;
+	if (on)
+		off_time = 0;
+	else
+		off_time += dt;
+}
+
+/*
+ * The thermocouple reading is translated to the ADC value by the default tip calibration.
+ * The calibration is done at 25 Celsius, the thermocouple measures the temperature difference, see TIP_CFG::tempCelsius()
+ */
+uint16_t TWIN_T12_PLANT::tempToADC(double t) {
+	double x = t - t_a + 25.0;								// Temperature, related to the calibration ambient
+	double v = 0;
+	if (x < cal_temp[0]) {
+		v = (x - 25.0) * cal_adc[0] / (cal_temp[0] - 25.0);
+	} else if (x >= cal_temp[3]) {
+		v = cal_adc[1] + (x - cal_temp[1]) * (cal_adc[3] - cal_adc[1]) / (cal_temp[3] - cal_temp[1]);
+	} else {
+		for (uint8_t j = 1; j < 4; ++j) {
+			if (x < cal_temp[j]) {
+				v = cal_adc[j-1] + (x - cal_temp[j-1]) * (cal_adc[j] - cal_adc[j-1]) / (cal_temp[j] - cal_temp[j-1]);
+				break;
+			}
+		}
+	}
+	if (v < 0)		v = 0;
+	if (v > 4095)	v = 4095;
+	return v;
+}
+
+// 10 kOhm NTC thermistor (beta 3950) with 10 kOhm resistor, see IRON_HW::ambientTemp()
+uint16_t TWIN_T12_PLANT::ambientToADC(double t) {
+	double r = 10000.0 * exp(3950.0 * (1.0 / (t + 273.15) - 1.0 / (25.0 + 273.15)));
+	return round(4095.0 / (1.0 + 10000.0 / r));
+}
+
+// Box-Muller transform of the linear congruential generator output
+double TWIN_T12_PLANT::noise(void) {
+	seed = seed * 1664525 + 1013904223;
+	double u1 = ((seed >> 8) + 1.0) / 16777217.0;
+	seed = seed * 1664525 + 1013904223;
+	double u2 = (seed >> 8) / 16777216.0;
+	return p.noise * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+double TWIN_T12_PLANT::uniform(void) {
+	seed = seed * 1664525 + 1013904223;
+	return (seed >> 8) / 16777216.0;
+}
+
+uint16_t TWIN_T12_PLANT::adc(uint32_t channel, bool heater_on) {
+	double v = 0;
+	switch (channel) {
+		case ADC_CHANNEL_2:									// IRON_CURRENT_Pin
+			if (heater_on && connected && c_sense)
+				v = p.current;
+			v += noise();
+			break;
+		case ADC_CHANNEL_4:									// IRON_TEMP_Pin
+			if (heater_on || !connected)					// The amplifier is saturated
+				return 4095;
+			v = tempToADC(t_s);
+			v += (4095 - v) * exp(-off_time / p.tc_settle);	// The amplifier is settling after power off
+			v += noise();
+			if (p.glitch > 0 && uniform() < p.glitch)
+				v = uniform() * 4096;
+			break;
+		case ADC_CHANNEL_6:									// AMBIENT_Pin
+			v = ambientToADC(t_a) + noise();
+			break;
+		default:
+			break;
+	}
+	if (v < 0)		v = 0;
+	if (v > 4095)	v = 4095;
+	return round(v);
+}
@@ -0,0 +1,100 @@
+/*
+ * twin.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * High level functions of the host twin: the controller boot and the user interaction
+ */
+
+#include "twin.h"
+#include "core.h"
+#include "config.h"
+
+extern I2C_HandleTypeDef	hi2c1;
+
+void twinExtiIRQ(void);										// See hal.cpp
+
+/*
+ * The EEPROM is prepared by the controller code itself, so the record layout is always actual.
+ * The separate configuration instance is used, the controller instance is initialized later by twinBoot()
+ */
+static CFG	prep(&hi2c1);
+
+void twinActivateTip(uint8_t index) {
+	prep.init();
+	prep.toggleTipActivation(index);						// The EEPROM is blank after twinReset(), the tip becomes active
+	prep.changeTip(index);
+}
+
+// The preset temperature in Celsius, should be called after twinActivateTip()
+void twinPresetTemp(uint16_t temp) {
+	prep.savePresetTempHuman(temp);
+	prep.saveConfig();
+}
+
+// Should be called after twinActivateTip()
+void twinPID(const PIDparam& pp) {
+	PIDparam p(pp);
+	prep.savePID(p);
+}
+
+// Should be called after twinActivateTip()
+void twinTipPID(const PIDparam& pp, const PIDmodel& m, bool smith) {
+	PIDparam p(pp);
+	prep.saveTipPID(p, &m, smith);
+}
+
+// Should be called after twinActivateTip()
+void twinBoost(uint8_t temp, uint8_t duration) {
+	prep.saveBoost(temp, duration);
+	prep.saveConfig();
+}
+
+// Should be called after twinActivateTip()
+void twinAdapt(bool on) {
+	prep.setup(prep.getOffTimeout(), prep.isBuzzerEnabled(), prep.isCelsius(), prep.isReedType(), prep.getLowTemp(), prep.getLowTO(),
+		prep.getScrTo(), on);
+	prep.saveConfig();
+}
+
+void twinSchedule(PID_SCHEDULE* ps) {
+	prep.saveSchedule(ps);
+}
+
+void twinBoot(void) {
+	setup();
+}
+
+// The main loop is called every millisecond, the hardware keeps running between the calls
+void twinRun(uint32_t ms) {
+	for (uint32_t i = 0; i < ms; ++i) {
+		loop();
+		HAL_Delay(1);
+	}
+}
+
+/*
+ * One encoder step: the interrupt is triggered by the ENCODER_L pin change.
+ * The rotation direction is the ENCODER_L level when the ENCODER_R pin goes low, see RENC::encoderIntr()
+ */
+void twinEncoder(int16_t steps) {
+	bool up = steps > 0;
+	if (steps < 0) steps = -steps;
+	for (int16_t i = 0; i < steps; ++i) {
+		twinPin(ENCODER_L_GPIO_Port, ENCODER_L_Pin, up);
+		twinPin(ENCODER_R_GPIO_Port, ENCODER_R_Pin, false);
+		twinExtiIRQ();
+		twinRun(2);
+		twinPin(ENCODER_R_GPIO_Port, ENCODER_R_Pin, true);
+		twinExtiIRQ();
+		twinPin(ENCODER_L_GPIO_Port, ENCODER_L_Pin, true);
+		twinRun(2);
+	}
+}
+
+void twinButton(uint32_t ms) {
+	twinPin(ENCODER_B_GPIO_Port, ENCODER_B_Pin, false);		// The button is active low
+	twinRun(ms);
+	twinPin(ENCODER_B_GPIO_Port, ENCODER_B_Pin, true);
+	twinRun(100);											// Let the button status debounced
+}
@@ -0,0 +1,73 @@
+/*
+ * twin_main.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * The host twin runner: boot the controller with one active tip, switch the IRON on and run it.
+ * Usage: twin [seconds]
+ * The trace of the IRON PWM, the raw samples drained from the controller sample ring (see adcSample() in core.cpp)
+ * and the display is printed every second, then the host time spent in the interrupt handlers
+ * and the ADC timing statistics collected by the controller (see adcTiming() in core.cpp).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "twin.h"
+#include "core.h"
+
+static void printFrame(void) {
+	const u8g2_text_t* text = 0;
+	uint8_t n = twinFrameText(&text);
+	for (uint8_t i = 0; i < n; ++i)
+		printf(" [%s]", text[i].str);
+}
+
+int main(int argc, char* argv[]) {
+	uint32_t seconds = 10;
+	if (argc > 1) seconds = atoi(argv[1]);
+
+	TWIN_STATIC_PLANT plant(600, 2000, 2048);				// The tip is connected and is colder than the preset temperature
+	twinAttach(&plant);
+	twinReset();
+	twinActivateTip(1);
+	twinBoot();
+	twinRun(1000);
+	twinButton(200);										// Short press: switch the IRON on
+	adcTimingReset();
+
+	uint64_t on_clocks = twinHeaterOnClocks();
+	for (uint32_t s = 0; s < seconds; ++s) {
+		uint32_t	n = 0;
+		ADC_SAMPLE	smp = {0};
+		for (uint8_t i = 0; i < 10; ++i) {					// The ring keeps about one second of samples
+			twinRun(100);
+			while (adcSample(&smp)) ++n;
+		}
+		uint64_t on = twinHeaterOnClocks();
+		printf("%4lu s: CCR1 = %4lu, duty = %5.1f%%, %3lu samples, T = %4u,", (unsigned long)(s+1), (unsigned long)TIM2->CCR1,
+			(double)(on - on_clocks) * 100.0 / TWIN_CPU_CLOCK, (unsigned long)n, smp.temp >> smp.frac);
+		on_clocks = on;
+		printFrame();
+		printf("\n");
+	}
+
+	static const char* isr_name[TWIN_ISR_NUM] = { "TIM2", "ADC", "JADC", "EXTI", "PendSV" };
+	printf("ISR      calls   avg, ns   max, ns\n");
+	for (uint8_t i = 0; i < TWIN_ISR_NUM; ++i) {
+		const TWIN_ISR_STAT* st = twinIsrStat((TWIN_ISR)i);
+		uint64_t avg = st->calls?st->total_ns / st->calls:0;
+		printf("%-6s %7lu %9lu %9lu\n", isr_name[i], (unsigned long)st->calls, (unsigned long)avg, (unsigned long)st->max_ns);
+	}
+	const ADC_TIMING* at = adcTiming();
+	static const char* stat_name[5] = { "ISR", "BH", "PID", "RSP", "JIT" };
+	const CYCLE_STAT* stat[5] = { &at->isr, &at->bh, &at->power, &at->response, &at->jitter };
+	printf("ADC      count  min, cyc  avg, cyc  max, cyc\n");
+	for (uint8_t i = 0; i < 5; ++i)
+		printf("%-6s %7lu %9lu %9lu %9lu\n", stat_name[i], (unsigned long)stat[i]->count,
+			(unsigned long)stat[i]->min, (unsigned long)stat[i]->avg, (unsigned long)stat[i]->max);
+	printf("Bottom half late: %lu\n", (unsigned long)at->bh_late);
+	printf("Samples dropped: %lu\n", (unsigned long)adcSampleOverrun());
+	printf("Temperature samples rejected: %lu\n", (unsigned long)adcRejected());
+	printf("Frames sent to the display: %lu\n", (unsigned long)twinFrames());
+	return 0;
+}
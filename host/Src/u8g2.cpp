@@ -0,0 +1,330 @@
+/*
+ * u8g2.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Host "digital twin" stand-in of the u8g2 library, see u8g2.h
+ * The frame is copied to the twin frame buffer on u8g2_SendBuffer()
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "u8g2.h"
+#include "twin.h"
+
+const u8g2_cb_t u8g2_cb_r0 = { 0 };
+const u8g2_cb_t u8g2_cb_r1 = { 1 };
+const u8g2_cb_t u8g2_cb_r2 = { 2 };
+const u8g2_cb_t u8g2_cb_r3 = { 3 };
+
+// Only the font header is used by the twin: max_char_width at offset 9, max_char_height at offset 10
+const uint8_t u8g_font_profont15r[] = { 95, 0, 3, 2, 3, 4, 3, 4, 4, 7, 15, 0, 252, 10, 252, 11, 253 };
+
+static const u8x8_display_info_t sh1106_128x64 = {
+	0,														// chip_enable_level
+	1,														// chip_disable_level
+	20,														// post_chip_enable_wait_ns
+	10,														// pre_chip_disable_wait_ns
+	5,														// reset_pulse_width_ms
+	5,														// post_reset_wait_ms
+	16,														// tile_width
+	8,														// tile_height
+	128,													// pixel_width
+	64														// pixel_height
+};
+
+static uint8_t		frame[U8G2_WIDTH * U8G2_HEIGHT / 8];	// Last sent frame
+static u8g2_text_t	frame_text[U8G2_TEXT_ITEMS];
+static uint8_t		frame_text_items	= 0;
+static uint32_t		frames				= 0;
+
+//---------------------- Twin frame buffer access --------------------------------
+uint32_t twinFrames(void) {
+	return frames;
+}
+
+const uint8_t* twinFrame(void) {
+	return frame;
+}
+
+bool twinFramePixel(uint8_t x, uint8_t y) {
+	if (x >= U8G2_WIDTH || y >= U8G2_HEIGHT) return false;
+	return frame[(y >> 3) * U8G2_WIDTH + x] & (1 << (y & 7));
+}
+
+uint8_t twinFrameText(const u8g2_text_t** text) {
+	if (text) *text = frame_text;
+	return frame_text_items;
+}
+
+bool twinFrameHas(const char* str) {
+	for (uint8_t i = 0; i < frame_text_items; ++i) {
+		if (strstr(frame_text[i].str, str))
+			return true;
+	}
+	return false;
+}
+
+//---------------------- The frame buffer ----------------------------------------
+extern "C" {
+
+static void drawPixel(u8g2_t *u8g2, int16_t x, int16_t y) {
+	if (x < 0 || x >= U8G2_WIDTH || y < 0 || y >= U8G2_HEIGHT) return;
+	if (u8g2->cb && u8g2->cb->rotation == 2) {				// 180 degrees
+		x = U8G2_WIDTH  - 1 - x;
+		y = U8G2_HEIGHT - 1 - y;
+	}
+	uint8_t* b = &u8g2->buffer[(y >> 3) * U8G2_WIDTH + x];
+	uint8_t  m = 1 << (y & 7);
+	switch (u8g2->draw_color) {
+		case 0:
+			*b &= ~m;
+			break;
+		case 2:
+			*b ^= m;
+			break;
+		default:
+			*b |= m;
+			break;
+	}
+}
+
+void u8g2_Setup_sh1106_128x64_noname_f(u8g2_t *u8g2, const u8g2_cb_t *rotation, u8x8_msg_cb byte_cb, u8x8_msg_cb gpio_and_delay_cb) {
+	memset(u8g2, 0, sizeof(u8g2_t));
+	u8g2->u8x8.display_info			= &sh1106_128x64;
+	u8g2->u8x8.byte_cb				= byte_cb;
+	u8g2->u8x8.gpio_and_delay_cb	= gpio_and_delay_cb;
+	u8g2->u8x8.next_cb				= u8x8_ascii_next;
+	u8g2->cb						= rotation;
+	u8g2->draw_color				= 1;
+}
+
+void u8g2_Setup_ssd1306_128x64_noname_f(u8g2_t *u8g2, const u8g2_cb_t *rotation, u8x8_msg_cb byte_cb, u8x8_msg_cb gpio_and_delay_cb) {
+	u8g2_Setup_sh1106_128x64_noname_f(u8g2, rotation, byte_cb, gpio_and_delay_cb);
+}
+
+void u8g2_Setup_ssd1309_128x64_noname2_f(u8g2_t *u8g2, const u8g2_cb_t *rotation, u8x8_msg_cb byte_cb, u8x8_msg_cb gpio_and_delay_cb) {
+	u8g2_Setup_sh1106_128x64_noname_f(u8g2, rotation, byte_cb, gpio_and_delay_cb);
+}
+
+// The display initialization sequence: the interface callbacks are called as the real library does
+void u8x8_InitDisplay(u8x8_t *u8x8) {
+	if (u8x8->gpio_and_delay_cb)
+		u8x8->gpio_and_delay_cb(u8x8, U8X8_MSG_GPIO_AND_DELAY_INIT, 0, NULL);
+	if (u8x8->byte_cb)
+		u8x8->byte_cb(u8x8, U8X8_MSG_BYTE_INIT, 0, NULL);
+}
+
+void u8x8_ClearDisplay(u8x8_t *u8x8) {
+	memset(frame, 0, sizeof(frame));
+	frame_text_items = 0;
+}
+
+void u8x8_SetPowerSave(u8x8_t *u8x8, uint8_t is_enable) {
+	u8x8->power_save = is_enable;
+}
+
+void u8x8_SetContrast(u8x8_t *u8x8, uint8_t value) {
+	u8x8->contrast = value;
+}
+
+void u8x8_SetFlipMode(u8x8_t *u8x8, uint8_t mode) {
+	u8x8->flip_mode = mode;
+}
+
+void u8x8_utf8_init(u8x8_t *u8x8) {
+	u8x8->utf8_state = 0;
+}
+
+uint16_t u8x8_ascii_next(u8x8_t *u8x8, uint8_t b) {
+	if (b == 0 || b == '\n') return 0x0ffff;
+	return b;
+}
+
+uint16_t u8x8_utf8_next(u8x8_t *u8x8, uint8_t b) {
+	return u8x8_ascii_next(u8x8, b);
+}
+
+void u8g2_SendBuffer(u8g2_t *u8g2) {
+	memcpy(frame, u8g2->buffer, sizeof(frame));
+	memcpy(frame_text, u8g2->text, sizeof(frame_text));
+	frame_text_items = u8g2->text_items;
+	++frames;
+}
+
+void u8g2_ClearBuffer(u8g2_t *u8g2) {
+	memset(u8g2->buffer, 0, sizeof(u8g2->buffer));
+	u8g2->text_items = 0;
+}
+
+uint8_t* u8g2_GetBufferPtr(u8g2_t *u8g2) {
+	return u8g2->buffer;
+}
+
+u8g2_uint_t u8g2_GetDisplayHeight(u8g2_t *u8g2) {
+	return U8G2_HEIGHT;
+}
+
+u8g2_uint_t u8g2_GetDisplayWidth(u8g2_t *u8g2) {
+	return U8G2_WIDTH;
+}
+
+void u8g2_SetDrawColor(u8g2_t *u8g2, uint8_t color) {
+	u8g2->draw_color = color;
+}
+
+uint8_t u8g2_GetDrawColor(u8g2_t *u8g2) {
+	return u8g2->draw_color;
+}
+
+void u8g2_SetContrast(u8g2_t *u8g2, uint8_t value) {
+	u8x8_SetContrast(&u8g2->u8x8, value);
+}
+
+void u8g2_DrawPixel(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y) {
+	drawPixel(u8g2, x, y);
+}
+
+void u8g2_DrawHLine(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t len) {
+	for (uint16_t i = 0; i < len; ++i)
+		drawPixel(u8g2, x+i, y);
+}
+
+void u8g2_DrawVLine(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t len) {
+	for (uint16_t i = 0; i < len; ++i)
+		drawPixel(u8g2, x, y+i);
+}
+
+void u8g2_DrawFrame(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h) {
+	if (w == 0 || h == 0) return;
+	u8g2_DrawHLine(u8g2, x, y, w);
+	u8g2_DrawHLine(u8g2, x, y+h-1, w);
+	u8g2_DrawVLine(u8g2, x, y, h);
+	u8g2_DrawVLine(u8g2, x+w-1, y, h);
+}
+
+void u8g2_DrawBox(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h) {
+	for (uint16_t i = 0; i < h; ++i)
+		u8g2_DrawHLine(u8g2, x, y+i, w);
+}
+
+// Bresenham line
+void u8g2_DrawLine(u8g2_t *u8g2, u8g2_uint_t x1, u8g2_uint_t y1, u8g2_uint_t x2, u8g2_uint_t y2) {
+	int16_t dx =  abs(x2 - x1), sx = (x1 < x2)?1:-1;
+	int16_t dy = -abs(y2 - y1), sy = (y1 < y2)?1:-1;
+	int16_t err = dx + dy;
+	int16_t x = x1, y = y1;
+	for (;;) {
+		drawPixel(u8g2, x, y);
+		if (x == x2 && y == y2) break;
+		int16_t e2 = 2*err;
+		if (e2 >= dy) { err += dy; x += sx; }
+		if (e2 <= dx) { err += dx; y += sy; }
+	}
+}
+
+// Filled triangle: the horizontal lines between the edges
+void u8g2_DrawTriangle(u8g2_t *u8g2, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+	int16_t y_min = y0, y_max = y0;
+	if (y1 < y_min) y_min = y1;
+	if (y2 < y_min) y_min = y2;
+	if (y1 > y_max) y_max = y1;
+	if (y2 > y_max) y_max = y2;
+	int16_t px[3] = { x0, x1, x2 }, py[3] = { y0, y1, y2 };
+	for (int16_t y = y_min; y <= y_max; ++y) {
+		int16_t xl = 32767, xr = -32768;
+		for (uint8_t e = 0; e < 3; ++e) {
+			uint8_t n = (e+1) % 3;
+			int16_t ya = py[e], yb = py[n];
+			if ((y < ya && y < yb) || (y > ya && y > yb)) continue;
+			int16_t x = px[e];
+			if (ya != yb)
+				x = px[e] + (int32_t)(px[n] - px[e]) * (y - ya) / (yb - ya);
+			if (x < xl) xl = x;
+			if (x > xr) xr = x;
+			if (ya == yb) {
+				if (px[n] < xl) xl = px[n];
+				if (px[n] > xr) xr = px[n];
+			}
+		}
+		for (int16_t x = xl; x <= xr; ++x)
+			drawPixel(u8g2, x, y);
+	}
+}
+
+// XBM bitmap is used by u8g2_DrawBitmap() in horizontal byte mode: cnt bytes per row, MSB first
+void u8g2_DrawBitmap(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t cnt, u8g2_uint_t h, const uint8_t *bitmap) {
+	for (uint16_t r = 0; r < h; ++r) {
+		for (uint16_t c = 0; c < cnt; ++c) {
+			uint8_t b = bitmap[r*cnt + c];
+			for (uint8_t i = 0; i < 8; ++i) {
+				if (b & (0x80 >> i))
+					drawPixel(u8g2, x + c*8 + i, y + r);
+			}
+		}
+	}
+}
+
+void u8g2_DrawXBM(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, const uint8_t *bitmap) {
+	uint16_t cnt = (w + 7) / 8;
+	for (uint16_t r = 0; r < h; ++r) {
+		for (uint16_t c = 0; c < w; ++c) {
+			if (bitmap[r*cnt + (c >> 3)] & (1 << (c & 7)))
+				drawPixel(u8g2, x + c, y + r);
+		}
+	}
+}
+
+void u8g2_DrawXBMP(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, const uint8_t *bitmap) {
+	u8g2_DrawXBM(u8g2, x, y, w, h, bitmap);
+}
+
+void u8g2_SetFont(u8g2_t *u8g2, const uint8_t *font) {
+	u8g2->font = font;
+}
+
+int8_t u8g2_GetMaxCharHeight(u8g2_t *u8g2) {
+	return u8g2->font?u8g2->font[10]:0;
+}
+
+int8_t u8g2_GetMaxCharWidth(u8g2_t *u8g2) {
+	return u8g2->font?u8g2->font[9]:0;
+}
+
+int8_t u8g2_GetAscent(u8g2_t *u8g2) {
+	return u8g2_GetMaxCharHeight(u8g2);
+}
+
+int8_t u8g2_GetDescent(u8g2_t *u8g2) {
+	return 0;
+}
+
+u8g2_uint_t u8g2_GetStrWidth(u8g2_t *u8g2, const char *s) {
+	return strlen(s) * u8g2_GetMaxCharWidth(u8g2);
+}
+
+u8g2_uint_t u8g2_GetUTF8Width(u8g2_t *u8g2, const char *str) {
+	return u8g2_GetStrWidth(u8g2, str);
+}
+
+// The string is not rasterized, it is recorded into the text list of the frame
+u8g2_uint_t u8g2_DrawStr(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, const char *str) {
+	if (u8g2->text_items < U8G2_TEXT_ITEMS) {
+		u8g2_text_t* t = &u8g2->text[u8g2->text_items++];
+		t->x = x; t->y = y;
+		strncpy(t->str, str, U8G2_TEXT_LEN-1);
+		t->str[U8G2_TEXT_LEN-1] = '\0';
+	}
+	return u8g2_GetStrWidth(u8g2, str);
+}
+
+u8g2_uint_t u8g2_DrawUTF8(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, const char *str) {
+	return u8g2_DrawStr(u8g2, x, y, str);
+}
+
+u8g2_uint_t u8g2_DrawGlyph(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, uint16_t encoding) {
+	char str[2] = { (char)encoding, '\0' };
+	return u8g2_DrawStr(u8g2, x, y, str);
+}
+
+}